@@ -0,0 +1,165 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "models/split_complex.h"
+#include "models/kronecker_tensor.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+/**
+ * Compares interleaved (MatrixXcd) and split (SplitStateVector, SplitDensityMatrix) layouts kernel by kernel. Both
+ * sides run the same algorithm: gates on one qubit are in-place butterflies over the two halves of every group, gates
+ * on several qubits gather groups of amplitudes, so the difference comes from the layout only.
+ * Usage: qbench [qubits of state vector] [qubits of density matrix]
+ */
+
+namespace {
+double seconds(const std::function<void()>& kernel, int repeats)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i)
+	kernel();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+}
+
+void report(const char* kernel, double interleaved, double split)
+{
+    printf("%-28s %12.6f %12.6f %8.2fx\n", kernel, interleaved, split, interleaved / split);
+}
+
+// interleaved counterpart of the single-subsystem kernel of SplitStateVector::applyToSubsystems(), column by column
+void applyRuns(const MatrixXcd& op, int index, const std::vector<uint>& dims, MatrixXcd& target)
+{
+    long long stride = 1;
+    for (int i = index + 1; i < dims.size(); ++i)
+	stride *= dims[i];
+    int dim = dims[index];
+    if (dim == 2) {
+	const std::complex<double> a = op(0, 0), b = op(0, 1), c = op(1, 0), d = op(1, 1);
+	for (int col = 0; col < target.cols(); ++col)
+	    for (std::complex<double>* x = target.col(col).data(); x < target.col(col).data() + target.rows(); x += 2 * stride)
+		for (long long low = 0; low < stride; ++low) {
+		    std::complex<double> first = x[low], second = x[low + stride];
+		    x[low] = a * first + b * second;
+		    x[low + stride] = c * first + d * second;
+		}
+	return;
+    }
+    std::vector<std::complex<double> > in(dim * stride);
+    for (int c = 0; c < target.cols(); ++c) {
+	std::complex<double>* data = target.col(c).data();
+	for (long long high = 0; high < target.rows(); high += dim * stride) {
+	    std::copy(data + high, data + high + dim * stride, in.begin());
+	    for (int row = 0; row < dim; ++row) {
+		std::complex<double>* out = data + high + row * stride;
+		for (long long low = 0; low < stride; ++low)
+		    out[low] = 0;
+		for (int col = 0; col < dim; ++col) {
+		    std::complex<double> a = op(row, col);
+		    const std::complex<double>* x = &in[col * stride];
+		    for (long long low = 0; low < stride; ++low)
+			out[low] += a * x[low];
+		}
+	    }
+	}
+    }
+}
+
+double interleavedExpectation(const MatrixXcd& op, int index, const std::vector<uint>& dims, const MatrixXcd& state)
+{
+    MatrixXcd applied = state;
+    applyRuns(op, index, dims, applied);
+    return (state.adjoint() * applied).trace().real();
+}
+}
+
+int main(int argc, char **argv) {
+    int vectorQubits = argc > 1 ? atoi(argv[1]) : 20;
+    int densityQubits = argc > 2 ? atoi(argv[2]) : 9;
+    MatrixXcd h(2, 2), z = MatrixXcd::Identity(2, 2), cnot = MatrixXcd::Identity(4, 4);
+    h << 1, 1, 1, -1;
+    h /= sqrt(2);
+    z(1, 1) = -1;
+    cnot.bottomRightCorner(2, 2) << 0, 1, 1, 0;
+    std::vector<int> low(1, vectorQubits - 1), high(1, 0), pair;
+    pair.push_back(0); pair.push_back(vectorQubits - 1);
+    volatile double sink = 0;
+    
+    std::vector<uint> dims(vectorQubits, 2);
+    MatrixXcd vec = VectorXcd::Random(1LL << vectorQubits);
+    vec.normalize();
+    SplitStateVector split(vec.col(0), HilbertSpace(dims));
+    printf("state vector, %d qubits\n%-28s %12s %12s %9s\n", vectorQubits, "kernel", "interleaved", "split", "speedup");
+    report("gate on lowest qubit",
+	   seconds([&]() { applyRuns(h, low[0], dims, vec); }, 5),
+	   seconds([&]() { split.apply(h, low); }, 5));
+    report("gate on highest qubit",
+	   seconds([&]() { applyRuns(h, high[0], dims, vec); }, 5),
+	   seconds([&]() { split.apply(h, high); }, 5));
+    report("two-qubit gate",
+	   seconds([&]() { KroneckerTensor::applyToSubsystems(cnot, pair, dims, vec); }, 5),
+	   seconds([&]() { split.apply(cnot, pair); }, 5));
+    report("probabilities",
+	   seconds([&]() { sink += vec.col(0).cwiseAbs2().sum(); }, 5),
+	   seconds([&]() { sink += split.probabilities().sum(); }, 5));
+    report("expectation",
+	   seconds([&]() { sink += interleavedExpectation(z, high[0], dims, vec); }, 5),
+	   seconds([&]() { sink += split.expectation(z, high); }, 5));
+    
+    std::vector<uint> densityDims(densityQubits, 2);
+    MatrixXcd a = MatrixXcd::Random(1 << densityQubits, 1 << densityQubits);
+    MatrixXcd density = a * a.adjoint();
+    density /= density.trace();
+    SplitDensityMatrix splitDensity(density, HilbertSpace(densityDims));
+    low[0] = densityQubits - 1;
+    pair[1] = densityQubits - 1;
+    printf("\ndensity matrix, %d qubits\n%-28s %12s %12s %9s\n", densityQubits, "kernel", "interleaved", "split", "speedup");
+    report("gate on lowest qubit",
+	   seconds([&]() {
+	       applyRuns(h, low[0], densityDims, density);
+	       density.adjointInPlace();
+	       applyRuns(h, low[0], densityDims, density);
+	   }, 3),
+	   seconds([&]() { splitDensity.apply(h, low); }, 3));
+    report("two-qubit gate",
+	   seconds([&]() {
+	       KroneckerTensor::applyToSubsystems(cnot, pair, densityDims, density);
+	       density.adjointInPlace();
+	       KroneckerTensor::applyToSubsystems(cnot, pair, densityDims, density);
+	   }, 3),
+	   seconds([&]() { splitDensity.apply(cnot, pair); }, 3));
+    report("probabilities",
+	   seconds([&]() { sink += density.diagonal().real().sum(); }, 5),
+	   seconds([&]() { sink += splitDensity.probabilities().sum(); }, 5));
+    report("expectation",
+	   seconds([&]() {
+	       MatrixXcd applied = density;
+	       applyRuns(z, high[0], densityDims, applied);
+	       sink += applied.trace().real();
+	   }, 3),
+	   seconds([&]() { sink += splitDensity.expectation(z, high); }, 3));
+    return 0;
+}
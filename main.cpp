@@ -27,7 +27,6 @@
 
 
 int main(int argc, char **argv) {
-    srand(time(0));
     MainHelper().run();// h;
 //     h.printWelcome();
 //     
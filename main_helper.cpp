@@ -29,6 +29,7 @@
 #include "models/transforms/hadamardgate.h"
 #include "models/transforms/controlledugate.h"
 #include "models/measurement.h"
+#include <ctime>
 
 MainHelper::MainHelper()
 {
@@ -131,6 +132,7 @@ vector< string > MainHelper::performMeasurementsOn(const std::vector< int >& sub
 {
     vector<string> res;
     Measurement measure = Proector(HilbertSpace(2));
+    measure.setRandomGenerator(RandomGenerator(time(0)));
     for (int i = 0; i < subsystems.size(); ++i) {
 // 	cout << "Probabilities on measure #" << i << ": ";
 	map<string, double> probs = measure.probabilities(*state, subsystems[i]);
@@ -0,0 +1,91 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "batch_runner.h"
+#include "random_generator.h"
+#include "work_stealing.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+BatchJob::BatchJob(const Circuit& circuit, const QuantumState& initial, int shots, const std::vector< int >& measured)
+    : circuit(circuit), initial(initial), shots(shots), measured(measured)
+{
+    if (circuit.space() != initial.space())
+	throw std::invalid_argument("State and circuit spaces are different");
+    if (shots < 0)
+	throw std::invalid_argument("Count of shots cannot be negative");
+    if (this->measured.empty())
+	for (int s = 0; s < initial.space().rank(); ++s)
+	    this->measured.push_back(s);
+}
+
+BatchResult::BatchResult(const QuantumState& state) : state(state)
+{
+}
+
+BatchRunner::BatchRunner(int threads, uint64_t seed)
+{
+    _threads = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    _seed = seed;
+}
+
+std::vector< BatchResult > BatchRunner::run(const std::vector< BatchJob >& jobs)
+{
+    std::vector< BatchResult > results;
+    for (int j = 0; j < jobs.size(); ++j)
+	results.push_back(BatchResult(jobs[j].initial));
+    
+    std::vector< MatrixXcd > scratch(_threads); // keeps its memory between jobs of the same size
+    _jobsPerWorker.assign(_threads, 0);
+    RandomGenerator generator(_seed);
+    runWorkStealing(jobs.size(), _threads, [&](int worker, int j) {
+	const BatchJob& job = jobs[j];
+	BatchResult& result = results[j];
+	scratch[worker] = job.initial.densityMatrix();
+	job.circuit.applyToDensity(scratch[worker]);
+	result.state.setMatrix(scratch[worker]);
+	result.probabilities = result.state.marginalProbabilities(std::vector< std::vector< int > >(1, job.measured))[0];
+	
+	std::vector< double > cumulative(result.probabilities.size());
+	double total = 0;
+	for (int k = 0; k < cumulative.size(); ++k)
+	    cumulative[k] = total += result.probabilities[k];
+	result.counts.assign(cumulative.size(), 0);
+	RandomGenerator shots = generator.split(j);
+	for (int shot = 0; shot < job.shots; ++shot) {
+	    int k = std::upper_bound(cumulative.begin(), cumulative.end(), shots.uniform() * total) - cumulative.begin();
+	    ++result.counts[std::min< int >(k, cumulative.size() - 1)];
+	}
+	++_jobsPerWorker[worker];
+    });
+    return results;
+}
+
+std::vector< int > BatchRunner::jobsPerWorker() const
+{
+    return _jobsPerWorker;
+}
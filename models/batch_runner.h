@@ -0,0 +1,85 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include "circuit.h"
+#include "quantum_state.h"
+#include <vector>
+#include <stdint.h>
+
+/**
+ * Independent simulation: circuit applied to initial state, then measurement of listed subsystems in computational
+ * basis repeated shots times
+ */
+struct BatchJob
+{
+    BatchJob(const Circuit& circuit, const QuantumState& initial, int shots, const std::vector< int >& measured = std::vector< int >());
+    
+    Circuit circuit;
+    QuantumState initial;
+    int shots;
+    std::vector< int > measured; // all subsystems if empty
+};
+
+struct BatchResult
+{
+    BatchResult(const QuantumState& state);
+    
+    QuantumState state; // after circuit, before measurement
+    std::vector< double > probabilities; // of outcomes, the first measured subsystem is the most significant
+    std::vector< int > counts; // of outcomes in shots
+};
+
+/**
+ * Runs many independent jobs on work-stealing pool of threads, see runWorkStealing(). Every worker keeps its own
+ * scratch density matrix; every job writes only its own result, so nothing is locked. Shots of job i are drawn from
+ * stream split(i) of the runner generator, so results depend on seed only, not on threads count or order of jobs
+ */
+class BatchRunner
+{
+public:
+    /**
+     * @param threads Count of workers, 0 means hardware concurrency
+     * @param seed Seed of shots, see RandomGenerator
+     */
+    BatchRunner(int threads = 0, uint64_t seed = 0);
+    
+    std::vector< BatchResult > run(const std::vector< BatchJob >& jobs);
+    
+    /**
+     * Count of jobs done by every worker during the last run
+     */
+    std::vector< int > jobsPerWorker() const;
+    
+private:
+    int _threads;
+    uint64_t _seed;
+    std::vector< int > _jobsPerWorker;
+};
+
+#endif // BATCH_RUNNER_H
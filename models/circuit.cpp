@@ -0,0 +1,119 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "circuit.h"
+#include "kronecker_tensor.h"
+#include <stdexcept>
+
+Circuit::Circuit(const HilbertSpace& space)
+{
+    _dimensions = space.dimensions();
+}
+
+Circuit::Circuit(const std::vector< uint >& dimensions)
+{
+    for (int i = 0; i < dimensions.size(); ++i)
+	if (dimensions[i] == 0)
+	    throw std::invalid_argument("Dimension cannot be zero");
+    _dimensions = dimensions;
+}
+
+void Circuit::addGate(const UnitaryTransformation& gate, const std::vector< int >& subsystems)
+{
+    std::vector< uint > dims;
+    for (int i = 0; i < subsystems.size(); ++i) {
+	if (subsystems[i] < 0 || subsystems[i] >= _dimensions.size())
+	    throw std::invalid_argument("Circuit space have not such subsystem");
+	for (int j = 0; j < i; ++j)
+	    if (subsystems[j] == subsystems[i])
+		throw std::invalid_argument("Subsystem cannot be listed twice");
+	dims.push_back(_dimensions[subsystems[i]]);
+    }
+    if (gate.space().totalDimension() != HilbertSpace(dims).totalDimension() || (gate.space().rank() > 1 && gate.space() != HilbertSpace(dims)))
+	throw std::invalid_argument("Space of gate must match dimensions of subsystems");
+    
+    CircuitGate item;
+    item.matrix = gate.transformMatrix();
+    item.subsystems = subsystems;
+    _gates.push_back(item);
+}
+
+void Circuit::addGate(const UnitaryTransformation& gate, int subsystem)
+{
+    addGate(gate, std::vector< int >(1, subsystem));
+}
+
+int Circuit::gatesCount() const
+{
+    return _gates.size();
+}
+
+const CircuitGate& Circuit::gate(int index) const
+{
+    return _gates.at(index);
+}
+
+HilbertSpace Circuit::space() const
+{
+    return HilbertSpace(_dimensions);
+}
+
+const std::vector< uint >& Circuit::dimensions() const
+{
+    return _dimensions;
+}
+
+int Circuit::rank() const
+{
+    return _dimensions.size();
+}
+
+void Circuit::applyTo(QuantumState* state) const
+{
+    if (state->space().dimensions() != _dimensions)
+	throw std::invalid_argument("State and circuit spaces are different");
+    MatrixXcd density = state->densityMatrix();
+    applyToDensity(density);
+    state->setMatrix(density);
+}
+
+void Circuit::applyToDensity(MatrixXcd& density) const
+{
+    // U * p * U^+ = U * (U * p)^+ since p is Hermit
+    for (int i = 0; i < _gates.size(); ++i) {
+	KroneckerTensor::applyToSubsystems(_gates[i].matrix, _gates[i].subsystems, _dimensions, density);
+	density.adjointInPlace();
+	KroneckerTensor::applyToSubsystems(_gates[i].matrix, _gates[i].subsystems, _dimensions, density);
+    }
+}
+
+void Circuit::applyTo(VectorXcd& vec) const
+{
+    MatrixXcd target = vec;
+    for (int i = 0; i < _gates.size(); ++i)
+	KroneckerTensor::applyToSubsystems(_gates[i].matrix, _gates[i].subsystems, _dimensions, target);
+    vec = target.col(0);
+}
@@ -0,0 +1,95 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef CIRCUIT_H
+#define CIRCUIT_H
+
+#include "../Eigen/Core"
+#include "hilbert_space.h"
+#include "quantum_state.h"
+#include "unitary_transformation.h"
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * One gate of circuit: local unitary matrix and subsystems it acts on, the first one is the most significant
+ */
+struct CircuitGate
+{
+    MatrixXcd matrix;
+    std::vector< int > subsystems;
+};
+
+/**
+ * Sequence of gates acting on subsystems of the space. Circuit only stores gates, engines decide how to simulate it
+ */
+class Circuit
+{
+public:
+    Circuit(const HilbertSpace& space);
+    
+    /**
+     * Circuit on subsystems of given dimensions. Their product may exceed int (wide circuits for TensorNetwork and
+     * PathSum), then only space() is unavailable
+     */
+    Circuit(const std::vector< uint >& dimensions);
+    
+    /**
+     * Append gate
+     * @param gate Transform whose space matches dimensions of listed subsystems
+     * @param subsystems Indexes of subsystems, in order of gate space
+     */
+    void addGate(const UnitaryTransformation& gate, const std::vector< int >& subsystems);
+    void addGate(const UnitaryTransformation& gate, int subsystem);
+    
+    int gatesCount() const;
+    const CircuitGate& gate(int index) const;
+    
+    /**
+     * Space of the circuit, throws std::invalid_argument when its total dimension does not fit in int
+     */
+    HilbertSpace space() const;
+    const std::vector< uint >& dimensions() const;
+    int rank() const;
+    
+    /**
+     * Apply all gates to the state (or state vector) with dense strided kernel, see KroneckerTensor::applyToSubsystems()
+     */
+    void applyTo(QuantumState* state) const;
+    void applyTo(VectorXcd& vec) const;
+    
+    /**
+     * Apply all gates to density matrix in place, U * p * U^+
+     */
+    void applyToDensity(MatrixXcd& density) const;
+    
+private:
+    std::vector< uint > _dimensions;
+    std::vector< CircuitGate > _gates;
+};
+
+#endif // CIRCUIT_H
@@ -0,0 +1,209 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "ensemble_state.h"
+#include "kronecker_tensor.h"
+#include "../Eigen/Eigenvalues"
+#include <stdexcept>
+
+#ifndef Constructors
+
+EnsembleState::EnsembleState()
+{
+}
+
+EnsembleState::EnsembleState(const VectorXcd& vec, const HilbertSpace& space)
+{
+    if (vec.size() != space.totalDimension())
+	throw std::invalid_argument("Space total dimension shold be the same as vector size");
+    _factor = vec.normalized();
+    _space = space;
+}
+
+EnsembleState EnsembleState::fromFactor(const MatrixXcd& factor, const HilbertSpace& space)
+{
+    if (factor.rows() != space.totalDimension())
+	throw std::invalid_argument("Space total dimension shold be the same as factor rows count");
+    if (factor.cols() == 0 || factor.norm() == 0)
+	throw std::invalid_argument("Factor should be nonzero");
+    EnsembleState res;
+    res._factor = factor / factor.norm();
+    res._space = space;
+    return res;
+}
+
+EnsembleState::EnsembleState(const QuantumState& state, double tolerance)
+{
+    SelfAdjointEigenSolver< MatrixXcd > solver(state.densityMatrix());
+    const VectorXd& values = solver.eigenvalues();
+    double maxValue = values.maxCoeff();
+    int rank = 0;
+    for (int i = 0; i < values.size(); ++i)
+	if (values[i] > tolerance * maxValue) ++rank;
+    
+    // eigen values are increasing, the largest ones are at the end
+    _factor.resize(values.size(), rank);
+    for (int k = 0; k < rank; ++k) {
+	int i = values.size() - 1 - k;
+	_factor.col(k) = solver.eigenvectors().col(i) * sqrt(values[i]);
+    }
+    _factor /= _factor.norm();
+    _space = state.space();
+}
+
+#endif
+
+#ifndef Performing
+
+void EnsembleState::apply(const MatrixXcd& op, const std::vector< int >& subsystems)
+{
+    KroneckerTensor::applyToSubsystems(op, subsystems, _space.dimensions(), _factor);
+}
+
+void EnsembleState::apply(const Circuit& circuit)
+{
+    if (circuit.space().totalDimension() != _space.totalDimension())
+	throw std::invalid_argument("Circuit space does not match state space");
+    for (int i = 0; i < circuit.gatesCount(); ++i)
+	apply(circuit.gate(i).matrix, circuit.gate(i).subsystems);
+}
+
+void EnsembleState::applyChannel(const std::vector< MatrixXcd >& kraus, const std::vector< int >& subsystems)
+{
+    if (kraus.empty())
+	throw std::invalid_argument("Channel should have at least one Kraus operator");
+    int rank = _factor.cols();
+    MatrixXcd res(_factor.rows(), rank * kraus.size());
+    for (int i = 0; i < kraus.size(); ++i) {
+	MatrixXcd part = _factor;
+	KroneckerTensor::applyToSubsystems(kraus[i], subsystems, _space.dimensions(), part);
+	res.middleCols(i * rank, rank) = part;
+    }
+    _factor = res;
+}
+
+int EnsembleState::measure(int subsystem, RandomGenerator& generator)
+{
+    _checkSubsystem(subsystem);
+    int dim = _space.dimension(subsystem);
+    int low = 1;
+    for (int i = subsystem + 1; i < _space.rank(); ++i)
+	low *= _space.dimension(i);
+    
+    VectorXd probs = probabilities();
+    std::vector< double > weights(dim, 0);
+    for (int row = 0; row < probs.size(); ++row)
+	weights[(row / low) % dim] += probs[row];
+    double r = generator.uniform() * probs.sum();
+    int outcome = 0;
+    while (outcome < dim - 1 && r >= weights[outcome])
+	r -= weights[outcome++];
+    
+    for (int row = 0; row < _factor.rows(); ++row)
+	if ((row / low) % dim != outcome) _factor.row(row).setZero();
+    _factor /= sqrt(weights[outcome]);
+    return outcome;
+}
+
+double EnsembleState::truncate(double tolerance)
+{
+    // L = U * S * V^+ and L^+ * L = V * S^2 * V^+, so L * V = U * S has orthogonal columns with weights S^2
+    MatrixXcd gram = _factor.adjoint() * _factor;
+    SelfAdjointEigenSolver< MatrixXcd > solver(gram);
+    const VectorXd& weights = solver.eigenvalues();
+    double total = weights.sum();
+    int rank = 0;
+    double dropped = 0;
+    for (int i = 0; i < weights.size(); ++i) {
+	if (weights[i] > tolerance * total) ++rank;
+	else dropped += weights[i];
+    }
+    if (rank == 0)
+	throw std::runtime_error("All branches of state are below tolerance");
+    
+    MatrixXcd branches = _factor * solver.eigenvectors().rightCols(rank);
+    _factor = branches / sqrt(total - dropped);
+    return dropped / total;
+}
+
+#endif
+
+#ifndef Getters
+
+VectorXd EnsembleState::probabilities() const
+{
+    return _factor.rowwise().squaredNorm();
+}
+
+std::complex< double > EnsembleState::expectation(const MatrixXcd& op, const std::vector< int >& subsystems) const
+{
+    MatrixXcd applied = _factor;
+    KroneckerTensor::applyToSubsystems(op, subsystems, _space.dimensions(), applied);
+    return (_factor.adjoint() * applied).trace();
+}
+
+double EnsembleState::purity() const
+{
+    MatrixXcd gram = _factor.adjoint() * _factor;
+    return gram.squaredNorm();
+}
+
+int EnsembleState::rank() const
+{
+    return _factor.cols();
+}
+
+const MatrixXcd& EnsembleState::factor() const
+{
+    return _factor;
+}
+
+HilbertSpace EnsembleState::space() const
+{
+    return _space;
+}
+
+MatrixXcd EnsembleState::densityMatrix() const
+{
+    return _factor * _factor.adjoint();
+}
+
+QuantumState EnsembleState::toQuantumState() const
+{
+    return QuantumState(densityMatrix(), _space);
+}
+
+#endif
+
+#ifndef Checks
+
+void EnsembleState::_checkSubsystem(int subsystem) const
+{
+    if (subsystem < 0 || subsystem >= _space.rank())
+	throw std::invalid_argument("Index of subsystem is outside of space bounds");
+}
+
+#endif
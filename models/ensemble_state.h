@@ -0,0 +1,117 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef ENSEMBLE_STATE_H
+#define ENSEMBLE_STATE_H
+
+#include "../Eigen/Core"
+#include "hilbert_space.h"
+#include "quantum_state.h"
+#include "circuit.h"
+#include "random_generator.h"
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * Mixed state of low rank stored as factor L with p = L * L^+. Column k is sqrt(p_k) |psi_k> of some ensemble, so
+ * storage is O(r * N) instead of O(N^2). Gates act on columns, probabilities and collapse are read from rows of L.
+ * Rank grows only by channels and is reduced by truncate()
+ */
+class EnsembleState
+{
+public:
+    /**
+     * Pure state, rank 1
+     */
+    EnsembleState(const VectorXcd& vec, const HilbertSpace& space);
+    
+    /**
+     * State L * L^+, factor is normalized to unit trace
+     */
+    static EnsembleState fromFactor(const MatrixXcd& factor, const HilbertSpace& space);
+    
+    /**
+     * Factor of general state from eigen decomposition, eigen values below tolerance are dropped
+     */
+    EnsembleState(const QuantumState& state, double tolerance = 1.0e-12);
+    
+    /**
+     * Apply operator to listed subsystems of every column, see KroneckerTensor::applyToSubsystems()
+     */
+    void apply(const MatrixXcd& op, const std::vector< int >& subsystems);
+    void apply(const Circuit& circuit);
+    
+    /**
+     * Apply channel with Kraus operators K_i on listed subsystems: L becomes [K_1 L, K_2 L, ...], rank is multiplied
+     * by operators count, so truncate() is usually called after
+     */
+    void applyChannel(const std::vector< MatrixXcd >& kraus, const std::vector< int >& subsystems);
+    
+    /**
+     * Measure subsystem in computational basis and collapse the state
+     * @return Index of outcome
+     */
+    int measure(int subsystem, RandomGenerator& generator);
+    
+    /**
+     * Reduce rank: eigen decomposition of r x r Gram matrix L^+ * L gives orthogonal branches, those with weight below
+     * tolerance (relative to trace) are dropped and the rest is renormalized
+     * @return Dropped weight
+     */
+    double truncate(double tolerance = 1.0e-12);
+    
+    VectorXd probabilities() const;
+    
+    /**
+     * Tr(p * O) = Tr(L^+ * O * L) for local operator
+     */
+    std::complex< double > expectation(const MatrixXcd& op, const std::vector< int >& subsystems) const;
+    
+    /**
+     * Tr(p^2) = ||L^+ * L||^2
+     */
+    double purity() const;
+    
+    int rank() const;
+    const MatrixXcd& factor() const;
+    HilbertSpace space() const;
+    
+    /**
+     * Build full density matrix (allocates N^2)
+     */
+    MatrixXcd densityMatrix() const;
+    QuantumState toQuantumState() const;
+    
+private:
+    MatrixXcd _factor;
+    HilbertSpace _space;
+    
+    EnsembleState();
+    void _checkSubsystem(int subsystem) const;
+};
+
+#endif // ENSEMBLE_STATE_H
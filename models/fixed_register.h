@@ -0,0 +1,302 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef FIXED_REGISTER_H
+#define FIXED_REGISTER_H
+
+#include "../Eigen/Core"
+#include "hilbert_space.h"
+#include "quantum_state.h"
+#include "random_generator.h"
+#include <complex>
+
+using namespace Eigen;
+
+/**
+ * State vector of N qubits with size known at compile time. Amplitudes and gate matrices are fixed-size Eigen types,
+ * so nothing is allocated on heap and loops over amplitudes have constant bounds the compiler can unroll.
+ * Arguments are not validated beyond debug asserts. Qubit 0 is the most significant, as subsystem 0 of HilbertSpace
+ */
+template < int N >
+class FixedRegister
+{
+public:
+    enum { Size = 1 << N };
+    typedef Matrix< std::complex< double >, Size, 1 > Vector;
+    typedef Matrix< double, Size, 1 > Probabilities;
+    
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    
+    /**
+     * Register in |0...0>
+     */
+    FixedRegister();
+    
+    void reset();
+    
+    /**
+     * Apply one-qubit gate; qubit given as template argument gives fully constant strides
+     */
+    template < int Q > void apply(const Matrix2cd& gate);
+    void apply(const Matrix2cd& gate, int qubit);
+    
+    /**
+     * Apply two-qubit gate, the first qubit is the most significant in gate matrix
+     */
+    template < int Q0, int Q1 > void apply(const Matrix4cd& gate);
+    void apply(const Matrix4cd& gate, int first, int second);
+    
+    /**
+     * Measure qubit in computational basis and collapse the register
+     * @return Outcome, 0 or 1
+     */
+    int measure(int qubit, RandomGenerator& generator);
+    
+    /**
+     * Expectation of Pauli Z on qubit
+     */
+    double expectationZ(int qubit) const;
+    
+    Probabilities probabilities() const;
+    const Vector& amplitudes() const;
+    Vector& amplitudes();
+    
+    /**
+     * Convert to general state (allocates)
+     */
+    QuantumState toQuantumState() const;
+    
+    static const Matrix2cd& hadamard();
+    static const Matrix2cd& pauliX();
+    static const Matrix2cd& pauliY();
+    static const Matrix2cd& pauliZ();
+    static Matrix2cd phaseShift(double teta);
+    static const Matrix4cd& cnot();
+    static const Matrix4cd& cz();
+    static const Matrix4cd& swap();
+    
+private:
+    Vector _amplitudes;
+};
+
+#ifndef Constructors
+
+template < int N >
+FixedRegister< N >::FixedRegister()
+{
+    EIGEN_STATIC_ASSERT(N >= 1 && N <= 5, YOU_MADE_A_PROGRAMMING_MISTAKE);
+    reset();
+}
+
+template < int N >
+void FixedRegister< N >::reset()
+{
+    _amplitudes.setZero();
+    _amplitudes[0] = 1;
+}
+
+#endif
+
+#ifndef Performing
+
+template < int N >
+template < int Q >
+void FixedRegister< N >::apply(const Matrix2cd& gate)
+{
+    EIGEN_STATIC_ASSERT(Q >= 0 && Q < N, YOU_MADE_A_PROGRAMMING_MISTAKE);
+    const int stride = 1 << (N - 1 - Q);
+    for (int high = 0; high < Size; high += 2 * stride)
+	for (int low = 0; low < stride; ++low) {
+	    std::complex< double > a = _amplitudes[high + low], b = _amplitudes[high + low + stride];
+	    _amplitudes[high + low] = gate(0, 0) * a + gate(0, 1) * b;
+	    _amplitudes[high + low + stride] = gate(1, 0) * a + gate(1, 1) * b;
+	}
+}
+
+template < int N >
+void FixedRegister< N >::apply(const Matrix2cd& gate, int qubit)
+{
+    eigen_assert(qubit >= 0 && qubit < N);
+    switch (qubit) {
+	case 0: apply< 0 >(gate); break;
+	case 1: apply< (N > 1 ? 1 : 0) >(gate); break;
+	case 2: apply< (N > 2 ? 2 : 0) >(gate); break;
+	case 3: apply< (N > 3 ? 3 : 0) >(gate); break;
+	default: apply< N - 1 >(gate);
+    }
+}
+
+template < int N >
+template < int Q0, int Q1 >
+void FixedRegister< N >::apply(const Matrix4cd& gate)
+{
+    EIGEN_STATIC_ASSERT(Q0 >= 0 && Q0 < N && Q1 >= 0 && Q1 < N && Q0 != Q1, YOU_MADE_A_PROGRAMMING_MISTAKE);
+    const int first = 1 << (N - 1 - Q0), second = 1 << (N - 1 - Q1);
+    const int offsets[4] = {0, second, first, first + second};
+    Matrix< std::complex< double >, 4, 1 > in;
+    for (int base = 0; base < Size; ++base) {
+	if ((base & first) || (base & second)) continue;
+	for (int a = 0; a < 4; ++a)
+	    in[a] = _amplitudes[base + offsets[a]];
+	for (int a = 0; a < 4; ++a)
+	    _amplitudes[base + offsets[a]] = gate.row(a) * in;
+    }
+}
+
+template < int N >
+void FixedRegister< N >::apply(const Matrix4cd& gate, int first, int second)
+{
+    eigen_assert(first >= 0 && first < N && second >= 0 && second < N && first != second);
+    const int strideFirst = 1 << (N - 1 - first), strideSecond = 1 << (N - 1 - second);
+    const int offsets[4] = {0, strideSecond, strideFirst, strideFirst + strideSecond};
+    Matrix< std::complex< double >, 4, 1 > in;
+    for (int base = 0; base < Size; ++base) {
+	if ((base & strideFirst) || (base & strideSecond)) continue;
+	for (int a = 0; a < 4; ++a)
+	    in[a] = _amplitudes[base + offsets[a]];
+	for (int a = 0; a < 4; ++a)
+	    _amplitudes[base + offsets[a]] = gate.row(a) * in;
+    }
+}
+
+template < int N >
+int FixedRegister< N >::measure(int qubit, RandomGenerator& generator)
+{
+    eigen_assert(qubit >= 0 && qubit < N);
+    const int stride = 1 << (N - 1 - qubit);
+    double one = 0;
+    for (int i = 0; i < Size; ++i)
+	if (i & stride) one += std::norm(_amplitudes[i]);
+    int outcome = generator.uniform() < one ? 1 : 0;
+    double scale = 1 / sqrt(outcome ? one : 1 - one);
+    for (int i = 0; i < Size; ++i)
+	_amplitudes[i] = ((i & stride) != 0) == (outcome == 1) ? _amplitudes[i] * scale : 0;
+    return outcome;
+}
+
+template < int N >
+double FixedRegister< N >::expectationZ(int qubit) const
+{
+    const int stride = 1 << (N - 1 - qubit);
+    double res = 0;
+    for (int i = 0; i < Size; ++i)
+	res += (i & stride) ? -std::norm(_amplitudes[i]) : std::norm(_amplitudes[i]);
+    return res;
+}
+
+#endif
+
+#ifndef Getters
+
+template < int N >
+typename FixedRegister< N >::Probabilities FixedRegister< N >::probabilities() const
+{
+    return _amplitudes.cwiseAbs2();
+}
+
+template < int N >
+const typename FixedRegister< N >::Vector& FixedRegister< N >::amplitudes() const
+{
+    return _amplitudes;
+}
+
+template < int N >
+typename FixedRegister< N >::Vector& FixedRegister< N >::amplitudes()
+{
+    return _amplitudes;
+}
+
+template < int N >
+QuantumState FixedRegister< N >::toQuantumState() const
+{
+    VectorXcd vec = _amplitudes;
+    return QuantumState(vec, HilbertSpace(std::vector< uint >(N, 2)));
+}
+
+#endif
+
+#ifndef Gates
+
+// Eigen matrices are not literal types, so gate matrices are built once as function-local constants
+
+template < int N >
+const Matrix2cd& FixedRegister< N >::hadamard()
+{
+    static const Matrix2cd matr = (Matrix2cd() << 1, 1, 1, -1).finished() / sqrt(2.0);
+    return matr;
+}
+
+template < int N >
+const Matrix2cd& FixedRegister< N >::pauliX()
+{
+    static const Matrix2cd matr = (Matrix2cd() << 0, 1, 1, 0).finished();
+    return matr;
+}
+
+template < int N >
+const Matrix2cd& FixedRegister< N >::pauliY()
+{
+    static const Matrix2cd matr = (Matrix2cd() << 0, std::complex< double >(0, -1), std::complex< double >(0, 1), 0).finished();
+    return matr;
+}
+
+template < int N >
+const Matrix2cd& FixedRegister< N >::pauliZ()
+{
+    static const Matrix2cd matr = (Matrix2cd() << 1, 0, 0, -1).finished();
+    return matr;
+}
+
+template < int N >
+Matrix2cd FixedRegister< N >::phaseShift(double teta)
+{
+    return (Matrix2cd() << 1, 0, 0, std::polar(1.0, teta)).finished();
+}
+
+template < int N >
+const Matrix4cd& FixedRegister< N >::cnot()
+{
+    static const Matrix4cd matr = (Matrix4cd() << 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0).finished();
+    return matr;
+}
+
+template < int N >
+const Matrix4cd& FixedRegister< N >::cz()
+{
+    static const Matrix4cd matr = (Matrix4cd() << 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, -1).finished();
+    return matr;
+}
+
+template < int N >
+const Matrix4cd& FixedRegister< N >::swap()
+{
+    static const Matrix4cd matr = (Matrix4cd() << 1, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 1).finished();
+    return matr;
+}
+
+#endif
+
+#endif // FIXED_REGISTER_H
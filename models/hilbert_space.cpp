@@ -25,6 +25,7 @@
 
 
 #include "hilbert_space.h"
+#include <limits>
 #include <stdexcept>
 
 using namespace std;
@@ -40,19 +41,20 @@ HilbertSpace::HilbertSpace()
 HilbertSpace::HilbertSpace(uint dim)
 {
     if (dim == 0) throw invalid_argument("Dimension cannot be zero");
+    _dim = _checkedProduct(1, dim);
     _rank = 1;
     _dimensions.push_back(dim);
-    _dim = dim;
 }
 
 HilbertSpace::HilbertSpace(const std::vector< uint >& dimensions) 
 {
     _rank = dimensions.size();
-    _dim = 1; // need to prevent multiply with default value
+    long long dim = 1; // need to prevent multiply with default value
     for (int i = 0; i < _rank; ++i)
 	if (dimensions[i] == 0)
 	    throw invalid_argument("Dimension cannot be zero");
-	else _dim *= dimensions[i];
+	else dim = _checkedProduct(dim, dimensions[i]);
+    _dim = dim;
     _dimensions = dimensions;
 }
 
@@ -68,10 +70,19 @@ HilbertSpace HilbertSpace::tensor(const HilbertSpace& first, const HilbertSpace&
 
 void HilbertSpace::tensorWith(const HilbertSpace& second)
 {
+    int dim = _checkedProduct(_dim, second._dim);
     _rank += second._rank;
     for (int i = 0; i < second._rank; ++i)
 	_dimensions.push_back(second._dimensions[i]);
-    _dim *= second._dim;
+    _dim = dim;
+}
+
+int HilbertSpace::_checkedProduct(long long first, long long second)
+{
+    // indexes are int everywhere, so a space of 2^31 states and more cannot be addressed
+    if (first != 0 && second > std::numeric_limits< int >::max() / first)
+	throw invalid_argument("Total dimension of space does not fit in int");
+    return first * second;
 }
 
 #endif
@@ -52,7 +52,8 @@ public:
     
     /**
      * Construct a tensor product of Hilbert spaces with specified dimensions
-     * @param dimensions Dimensions of components of the result space, must be strongly positive
+     * @param dimensions Dimensions of components of the result space, must be strongly positive; their product must fit
+     * in int, wider registers are described by dimensions alone (see Circuit)
      */
     HilbertSpace(const std::vector< uint >& dimensions);
     
@@ -105,6 +106,8 @@ public:
 private:
     int _rank, _dim;
     std::vector< uint > _dimensions;
+    
+    static int _checkedProduct(long long first, long long second);
 
 };
 
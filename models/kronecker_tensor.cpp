@@ -25,6 +25,9 @@
 
 
 #include "kronecker_tensor.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
 
 MatrixXcd KroneckerTensor::product(const MatrixXcd& a, const MatrixXcd& b)
 {
@@ -54,4 +57,276 @@ MatrixXcd KroneckerTensor::getIdentityMatrix(uint dimension)
     MatrixXcd i(dimension, dimension);
     i.setIdentity();
     return i;
-}
\ No newline at end of file
+}
+
+void KroneckerTensor::applyToSubsystems(const MatrixXcd& op, const std::vector< int >& subsystems, const std::vector< uint >& dimensions, MatrixXcd& target)
+{
+    long long size = 1;
+    for (int i = 0; i < dimensions.size(); ++i)
+	size *= dimensions[i];
+    if (target.rows() != (dimensions.empty() ? 0 : size))
+	throw std::invalid_argument("Target size does not match space dimension");
+    localDimension(subsystems, dimensions);
+    if (_isSwap(op, subsystems, dimensions)) {
+	swapSubsystems(subsystems[0], subsystems[1], dimensions, target, false);
+	return;
+    }
+    for (int col = 0; col < target.cols(); ++col)
+	applyToSubsystems(op, subsystems, dimensions, target.col(col).data(), 0, target.rows());
+}
+
+void KroneckerTensor::applyToSubsystems(const MatrixXcd& op, const std::vector< int >& subsystems, const std::vector< uint >& dimensions, std::complex< double >* data, long long begin, long long end)
+{
+    std::vector< long long > strides(dimensions.size(), 1);
+    for (int i = (int) dimensions.size() - 2; i >= 0; --i)
+	strides[i] = strides[i + 1] * dimensions[i + 1];
+    
+    // offsets[a] is the shift of global index when local index of subsystems is a
+    int localDim = localDimension(subsystems, dimensions);
+    if (op.rows() != localDim || op.cols() != localDim)
+	throw std::invalid_argument("Operator size does not match subsystems dimensions");
+    
+    std::vector< long long > offsets(localDim, 0);
+    for (int a = 0; a < localDim; ++a) {
+	int rest = a;
+	for (int i = (int) subsystems.size() - 1; i >= 0; --i) {
+	    offsets[a] += (rest % dimensions[subsystems[i]]) * strides[subsystems[i]];
+	    rest /= dimensions[subsystems[i]];
+	}
+    }
+    
+    // group g is numbered by digits of the other subsystems, its first index is found by odometer over them
+    std::vector< bool > isTarget(dimensions.size(), false);
+    for (int i = 0; i < subsystems.size(); ++i)
+	isTarget[subsystems[i]] = true;
+    std::vector< int > rest;
+    for (int i = 0; i < dimensions.size(); ++i)
+	if (!isTarget[i]) rest.push_back(i);
+    long long groups = 1;
+    for (int i = 0; i < rest.size(); ++i)
+	groups *= dimensions[rest[i]];
+    end = std::min(end, groups);
+    if (begin >= end)
+	return;
+    std::vector< int > digits(rest.size(), 0);
+    long long base = 0, left = begin;
+    for (int i = (int) rest.size() - 1; i >= 0; --i) {
+	digits[i] = left % dimensions[rest[i]];
+	base += digits[i] * strides[rest[i]];
+	left /= dimensions[rest[i]];
+    }
+    
+    VectorXcd in(localDim), out(localDim);
+    for (long long group = begin; group < end; ++group) {
+	for (int a = 0; a < localDim; ++a)
+	    in[a] = data[base + offsets[a]];
+	out.noalias() = op * in;
+	for (int a = 0; a < localDim; ++a)
+	    data[base + offsets[a]] = out[a];
+	
+	for (int i = (int) rest.size() - 1; i >= 0; --i) {
+	    base += strides[rest[i]];
+	    if (++digits[i] < dimensions[rest[i]]) break;
+	    base -= digits[i] * strides[rest[i]];
+	    digits[i] = 0;
+	}
+    }
+}
+
+long long KroneckerTensor::localDimension(const std::vector< int >& subsystems, const std::vector< uint >& dimensions)
+{
+    long long res = 1;
+    std::vector< bool > used(dimensions.size(), false);
+    for (int i = 0; i < subsystems.size(); ++i) {
+	if (subsystems[i] < 0 || subsystems[i] >= dimensions.size())
+	    throw std::invalid_argument("Index of subsystem is outside of space bounds");
+	if (used[subsystems[i]])
+	    throw std::invalid_argument("Subsystem cannot be listed twice");
+	used[subsystems[i]] = true;
+	res *= dimensions[subsystems[i]];
+    }
+    return res;
+}
+
+void KroneckerTensor::applyToSubsystem(const MatrixXcd& op, int index, const std::vector< uint >& dimensions, MatrixXcd& target)
+{
+    applyToSubsystems(op, std::vector< int >(1, index), dimensions, target);
+}
+
+void KroneckerTensor::permuteSubsystems(const std::vector< int >& perm, const std::vector< uint >& dimensions, MatrixXcd& target, int threads)
+{
+    int rank = dimensions.size();
+    if (perm.size() != rank)
+	throw std::invalid_argument("Permutation size does not match subsystems count");
+    std::vector< bool > used(rank, false);
+    for (int i = 0; i < rank; ++i) {
+	if (perm[i] < 0 || perm[i] >= rank || used[perm[i]])
+	    throw std::invalid_argument("Not a permutation of subsystem indexes");
+	used[perm[i]] = true;
+    }
+    
+    // cycles over subsystems of equal dimensions are chains of in-place swaps; current[i] is subsystem now at place i
+    std::vector< int > current(rank), swaps;
+    for (int i = 0; i < rank; ++i)
+	current[i] = i;
+    bool inPlace = true;
+    for (int i = 0; i < rank && inPlace; ++i) {
+	if (current[i] == perm[i]) continue;
+	int j = std::find(current.begin() + i, current.end(), perm[i]) - current.begin();
+	inPlace = dimensions[current[i]] == dimensions[current[j]];
+	std::swap(current[i], current[j]);
+	swaps.push_back(i);
+	swaps.push_back(j);
+    }
+    if (inPlace) {
+	for (int k = 0; k < swaps.size(); k += 2)
+	    swapSubsystems(swaps[k], swaps[k + 1], dimensions, target, true, threads);
+	return;
+    }
+    
+    std::vector< int > strides(rank, 1);
+    for (int i = rank - 2; i >= 0; --i)
+	strides[i] = strides[i + 1] * dimensions[i + 1];
+    int size = rank == 0 ? 1 : strides[0] * dimensions[0];
+    if (target.rows() != size || (target.cols() != 1 && target.cols() != size))
+	throw std::invalid_argument("Target size does not match space dimension");
+    
+    // trailing subsystems kept in place are not split, they are copied as one segment
+    int kept = rank, segment = 1;
+    while (kept > 0 && perm[kept - 1] == kept - 1)
+	segment *= dimensions[--kept];
+    if (kept == 0) return;
+    
+    // offsets[b] is index in target where b-th segment of result starts; walk digits of result as odometer
+    std::vector< int > offsets(size / segment, 0);
+    std::vector< int > digits(kept, 0);
+    for (int b = 1; b < offsets.size(); ++b) {
+	int offset = offsets[b - 1];
+	for (int i = kept - 1; i >= 0; --i) {
+	    offset += strides[perm[i]];
+	    if (++digits[i] < dimensions[perm[i]]) break;
+	    offset -= digits[i] * strides[perm[i]];
+	    digits[i] = 0;
+	}
+	offsets[b] = offset;
+    }
+    
+    MatrixXcd res(target.rows(), target.cols());
+    int units = target.cols() == 1 ? offsets.size() : size;
+    if (threads <= 0)
+	threads = std::max(1u, std::thread::hardware_concurrency());
+    if ((long long) target.rows() * target.cols() < (1 << 16))
+	threads = 1;
+    threads = std::min(threads, units);
+    
+    std::vector< std::thread > workers;
+    for (int t = 1; t < threads; ++t)
+	workers.push_back(std::thread(_permuteRange, std::cref(target), std::ref(res), std::cref(offsets), segment,
+				      (long long) units * t / threads, (long long) units * (t + 1) / threads));
+    _permuteRange(target, res, offsets, segment, 0, units / threads);
+    for (int t = 0; t < workers.size(); ++t)
+	workers[t].join();
+    target.swap(res);
+}
+
+void KroneckerTensor::swapSubsystems(int first, int second, const std::vector< uint >& dimensions, MatrixXcd& target, bool bothSides, int threads)
+{
+    int rank = dimensions.size();
+    if (first < 0 || first >= rank || second < 0 || second >= rank)
+	throw std::invalid_argument("Index of subsystem is outside of space bounds");
+    if (dimensions[first] != dimensions[second])
+	throw std::invalid_argument("Swapped subsystems must have equal dimensions");
+    std::vector< long long > strides(rank, 1);
+    for (int i = rank - 2; i >= 0; --i)
+	strides[i] = strides[i + 1] * dimensions[i + 1];
+    long long size = rank == 0 ? 1 : strides[0] * dimensions[0];
+    if (target.rows() != size || (bothSides && target.cols() != 1 && target.cols() != size))
+	throw std::invalid_argument("Target size does not match space dimension");
+    if (first == second) return;
+    
+    int high = std::min(first, second), low = std::max(first, second);
+    bool columns = bothSides && target.cols() != 1;
+    // a vector is cut into blocks between digits of high subsystem (see _swapRange), a matrix into columns
+    long long units = target.cols() == 1 ? size / strides[low] / dimensions[low] / dimensions[high] : target.cols();
+    if (threads <= 0)
+	threads = std::max(1u, std::thread::hardware_concurrency());
+    if ((long long) target.rows() * target.cols() < (1 << 16))
+	threads = 1;
+    threads = std::min< long long >(threads, units);
+    
+    std::vector< std::thread > workers;
+    for (int t = 1; t < threads; ++t)
+	workers.push_back(std::thread(_swapRange, std::ref(target), dimensions[high], strides[high], strides[low], columns,
+				      units * t / threads, units * (t + 1) / threads));
+    _swapRange(target, dimensions[high], strides[high], strides[low], columns, 0, units / threads);
+    for (int t = 0; t < workers.size(); ++t)
+	workers[t].join();
+}
+
+void KroneckerTensor::_swapRange(MatrixXcd& target, int dim, long long highStride, long long lowStride, bool columns, long long begin, long long end)
+{
+    if (target.cols() == 1) {
+	_swapRuns(target.data(), dim, highStride, lowStride, begin, end);
+	return;
+    }
+    long long units = target.rows() / lowStride / dim / dim;
+    for (long long col = begin; col < end; ++col) {
+	int x = (col / highStride) % dim, y = (col / lowStride) % dim;
+	if (!columns || x == y) {
+	    _swapRuns(target.col(col).data(), dim, highStride, lowStride, 0, units);
+	    continue;
+	}
+	if (x > y) continue; // done together with its partner
+	long long partner = col + (y - x) * highStride + (x - y) * lowStride;
+	_swapRuns(target.col(col).data(), dim, highStride, lowStride, 0, units);
+	_swapRuns(target.col(partner).data(), dim, highStride, lowStride, 0, units);
+	target.col(col).swap(target.col(partner));
+    }
+}
+
+void KroneckerTensor::_swapRuns(std::complex< double >* data, int dim, long long highStride, long long lowStride, long long begin, long long end)
+{
+    // index is [outer | high digit x | middle | low digit y | run]; unit is a pair (outer, middle). Amplitudes with
+    // x < y trade places with (y, x), each move is a contiguous run of lowStride elements
+    long long middleCount = highStride / (lowStride * dim);
+    for (long long unit = begin; unit < end; ++unit) {
+	std::complex< double >* base = data + unit / middleCount * highStride * dim + unit % middleCount * lowStride * dim;
+	for (int x = 0; x < dim; ++x)
+	    for (int y = x + 1; y < dim; ++y) {
+		std::complex< double >* from = base + x * highStride + y * lowStride;
+		std::swap_ranges(from, from + lowStride, base + y * highStride + x * lowStride);
+	    }
+    }
+}
+
+bool KroneckerTensor::_isSwap(const MatrixXcd& op, const std::vector< int >& subsystems, const std::vector< uint >& dimensions)
+{
+    if (subsystems.size() != 2 || subsystems[0] == subsystems[1])
+	return false;
+    for (int i = 0; i < 2; ++i)
+	if (subsystems[i] < 0 || subsystems[i] >= dimensions.size())
+	    return false;
+    int dim = dimensions[subsystems[0]];
+    if (dimensions[subsystems[1]] != dim || op.rows() != dim * dim || op.cols() != dim * dim)
+	return false;
+    for (int col = 0; col < op.cols(); ++col)
+	for (int row = 0; row < op.rows(); ++row)
+	    if (op(row, col) != std::complex< double >(row == col % dim * dim + col / dim ? 1 : 0))
+		return false;
+    return true;
+}
+
+void KroneckerTensor::_permuteRange(const MatrixXcd& source, MatrixXcd& target, const std::vector< int >& offsets, int segment, int begin, int end)
+{
+    if (source.cols() == 1) {
+	for (int b = begin; b < end; ++b)
+	    target.col(0).segment(b * segment, segment) = source.col(0).segment(offsets[b], segment);
+	return;
+    }
+    // whole columns are processed one by one, so both source and result columns stay in cache while segments are gathered
+    for (int col = begin; col < end; ++col) {
+	int sourceCol = offsets[col / segment] + col % segment;
+	for (int b = 0; b < offsets.size(); ++b)
+	    target.col(col).segment(b * segment, segment) = source.col(sourceCol).segment(offsets[b], segment);
+    }
+}
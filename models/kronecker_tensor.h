@@ -37,7 +37,56 @@ public:
     static MatrixXcd product(const MatrixXcd& a, const MatrixXcd& b);
     static MatrixXcd expand(const MatrixXcd& initial, int index, const std::vector< uint >& dimensions);
     static MatrixXcd getIdentityMatrix(uint dimension);
+    
+    /**
+     * Multiply target by expanded operator from the left without constructing expanded matrix: target = (I x op x I) * target.
+     * Costs O(rows * cols * op.rows()) instead of O(rows^2 * cols)
+     * @param op Operator acting on the tensor product of subsystems listed in subsystems, first one is the most significant
+     * @param subsystems Indexes of subsystems op acts on
+     * @param dimensions Dimensions of all subsystems of the space; their product must be equal to target rows count
+     * @param target Matrix or vector (one column) to be changed
+     */
+    static void applyToSubsystems(const MatrixXcd& op, const std::vector< int >& subsystems, const std::vector< uint >& dimensions, MatrixXcd& target);
+    static void applyToSubsystem(const MatrixXcd& op, int index, const std::vector< uint >& dimensions, MatrixXcd& target);
+    
+    /**
+     * The same for one vector given by pointer, only groups of amplitudes number [begin, end) are changed. Groups are
+     * numbered by index over the other subsystems, end is clamped to their count. Ranges that split the groups can be
+     * processed by different threads at once
+     */
+    static void applyToSubsystems(const MatrixXcd& op, const std::vector< int >& subsystems, const std::vector< uint >& dimensions, std::complex< double >* data, long long begin, long long end);
+    
+    /**
+     * Product of dimensions of subsystems, i.e. size of operator acting on them. Throws std::invalid_argument if a
+     * subsystem is outside of space bounds or listed twice, kernels that compute offsets of amplitudes rely on it
+     */
+    static long long localDimension(const std::vector< int >& subsystems, const std::vector< uint >& dimensions);
+    
+    /**
+     * Reorder subsystems of state vector (one column) or density matrix (both rows and columns): subsystem i of result is
+     * subsystem perm[i] of target. When every cycle of perm moves subsystems of equal dimensions (always for qubits),
+     * it is done in place as a chain of swapSubsystems(). Otherwise trailing subsystems that stay in place are copied as
+     * contiguous segments, columns (or segments of vector) are shared between threads, and one temporary of target
+     * size is used
+     * @param perm Permutation of subsystem indexes
+     * @param dimensions Dimensions of subsystems before permutation
+     * @param target Vector or square matrix to be changed
+     * @param threads Count of worker threads, 0 means hardware concurrency; small targets are always done in one thread
+     */
+    static void permuteSubsystems(const std::vector< int >& perm, const std::vector< uint >& dimensions, MatrixXcd& target, int threads = 0);
+    
+    /**
+     * Swap two subsystems of equal dimension in place. Amplitudes move as contiguous runs below the less significant
+     * subsystem, blocks of vector (or columns of matrix) are shared between threads. applyToSubsystems() uses it for
+     * SWAP gate matrix
+     * @param bothSides Square target is changed as S * target * S^+, otherwise only its rows are swapped (S * target)
+     */
+    static void swapSubsystems(int first, int second, const std::vector< uint >& dimensions, MatrixXcd& target, bool bothSides = true, int threads = 0);
 private:
+    static void _permuteRange(const MatrixXcd& source, MatrixXcd& target, const std::vector< int >& offsets, int segment, int begin, int end);
+    static void _swapRange(MatrixXcd& target, int dim, long long highStride, long long lowStride, bool columns, long long begin, long long end);
+    static void _swapRuns(std::complex< double >* data, int dim, long long highStride, long long lowStride, long long begin, long long end);
+    static bool _isSwap(const MatrixXcd& op, const std::vector< int >& subsystems, const std::vector< uint >& dimensions);
 };
 
 #endif // KRONECKER_TENSOR_H
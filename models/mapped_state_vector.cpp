@@ -0,0 +1,286 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "mapped_state_vector.h"
+#include "kronecker_tensor.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef Constructors
+
+MappedStateVector::MappedStateVector(const std::vector< uint >& dimensions, const std::string& path, int localSubsystems)
+{
+    int rank = dimensions.size();
+    if (localSubsystems < 1 || localSubsystems > rank)
+	throw std::invalid_argument("Count of local subsystems must be between one and count of subsystems");
+    const long long maxSize = std::numeric_limits< long long >::max() / sizeof(std::complex< double >);
+    _size = 1;
+    for (int i = 0; i < rank; ++i) {
+	if (dimensions[i] == 0)
+	    throw std::invalid_argument("Dimension cannot be zero");
+	if (_size > maxSize / dimensions[i])
+	    throw std::invalid_argument("State vector is too large for file");
+	_size *= dimensions[i];
+    }
+    _dimensions = dimensions;
+    _path = path;
+    _slotDims = dimensions;
+    _slotStrides.assign(rank, 1);
+    for (int i = rank - 2; i >= 0; --i)
+	_slotStrides[i] = _slotStrides[i + 1] * _slotDims[i + 1];
+    _firstLocal = rank - localSubsystems;
+    _chunkSize = _firstLocal == 0 ? _size : _slotStrides[_firstLocal - 1];
+    for (int s = 0; s < rank; ++s) {
+	_slotOf.push_back(s);
+	_subsystemIn.push_back(s);
+    }
+    _passes = _swaps = 0;
+    
+    // new file is filled with zeros, so only the first amplitude is to be written
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (_fd < 0)
+	throw std::runtime_error("Cannot create file for state vector");
+    size_t bytes = _size * sizeof(std::complex< double >);
+    if (ftruncate(_fd, bytes) != 0) {
+	close(_fd);
+	unlink(path.c_str());
+	throw std::runtime_error("Cannot allocate file for state vector");
+    }
+    void* data = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (data == MAP_FAILED) {
+	close(_fd);
+	unlink(path.c_str());
+	throw std::runtime_error("Cannot map file of state vector");
+    }
+    _data = static_cast< std::complex< double >* >(data);
+    _data[0] = 1;
+}
+
+MappedStateVector::~MappedStateVector()
+{
+    munmap(_data, _size * sizeof(std::complex< double >));
+    close(_fd);
+    unlink(_path.c_str());
+}
+
+#endif
+
+void MappedStateVector::_advise(long long chunk, int advice) const
+{
+    long long page = sysconf(_SC_PAGESIZE);
+    long long begin = chunk * _chunkSize * sizeof(std::complex< double >);
+    long long length = _chunkSize * sizeof(std::complex< double >) + begin % page;
+    madvise(reinterpret_cast< char* >(_data) + begin - begin % page, length, advice);
+}
+
+long long MappedStateVector::_index(const std::vector< int >& digits) const
+{
+    if (digits.size() != _slotOf.size())
+	throw std::invalid_argument("Basis state must have digit for every subsystem");
+    long long index = 0;
+    for (int s = 0; s < digits.size(); ++s) {
+	if (digits[s] < 0 || digits[s] >= _slotDims[_slotOf[s]])
+	    throw std::invalid_argument("Digit is out of subsystem dimension");
+	index += digits[s] * _slotStrides[_slotOf[s]];
+    }
+    return index;
+}
+
+#ifndef Performing
+
+void MappedStateVector::apply(const Circuit& circuit)
+{
+    if (circuit.dimensions() != _dimensions)
+	throw std::invalid_argument("State and circuit spaces are different");
+    std::vector< CircuitGate > pending;
+    for (int g = 0; g < circuit.gatesCount(); ++g) {
+	if (circuit.gate(g).subsystems.size() > _slotDims.size() - _firstLocal)
+	    throw std::invalid_argument("Gate is wider than chunk");
+	pending.push_back(circuit.gate(g));
+    }
+    
+    while (!pending.empty()) {
+	// gate joins the batch if it is local and does not follow a skipped gate on the same subsystem
+	std::vector< CircuitGate > batch, rest;
+	std::vector< bool > blocked(_slotOf.size(), false);
+	for (int g = 0; g < pending.size(); ++g) {
+	    const std::vector< int >& subs = pending[g].subsystems;
+	    bool free = true, local = true;
+	    for (int i = 0; i < subs.size(); ++i) {
+		free = free && !blocked[subs[i]];
+		local = local && _slotOf[subs[i]] >= _firstLocal;
+	    }
+	    if (free && local) {
+		CircuitGate gate = pending[g];
+		for (int i = 0; i < subs.size(); ++i)
+		    gate.subsystems[i] = _slotOf[subs[i]] - _firstLocal;
+		batch.push_back(gate);
+	    }
+	    else {
+		rest.push_back(pending[g]);
+		for (int i = 0; i < subs.size(); ++i)
+		    blocked[subs[i]] = true;
+	    }
+	}
+	pending.swap(rest);
+	if (!batch.empty()) {
+	    _applyBatch(batch);
+	    continue;
+	}
+	
+	// the first gate needs global subsystems: swap each with local slot whose subsystem is needed latest
+	const std::vector< int >& subs = pending[0].subsystems;
+	for (int i = 0; i < subs.size(); ++i) {
+	    if (_slotOf[subs[i]] >= _firstLocal) continue;
+	    int victim = -1, victimUse = -1;
+	    for (int slot = _firstLocal; slot < _slotDims.size(); ++slot) {
+		int sub = _subsystemIn[slot];
+		if (_slotDims[slot] != _slotDims[_slotOf[subs[i]]] || std::find(subs.begin(), subs.end(), sub) != subs.end())
+		    continue;
+		int use = 1;
+		while (use < pending.size() && std::find(pending[use].subsystems.begin(), pending[use].subsystems.end(), sub) == pending[use].subsystems.end())
+		    ++use;
+		if (use > victimUse) {
+		    victim = slot;
+		    victimUse = use;
+		}
+	    }
+	    if (victim < 0)
+		throw std::runtime_error("No local subsystem of the same dimension to swap with");
+	    _swapSlots(_slotOf[subs[i]], victim);
+	}
+    }
+}
+
+void MappedStateVector::_applyBatch(const std::vector< CircuitGate >& batch)
+{
+    std::vector< uint > localDims(_slotDims.begin() + _firstLocal, _slotDims.end());
+    long long chunks = chunksCount();
+    for (long long c = 0; c < chunks; ++c) {
+	if (c + 1 < chunks)
+	    _advise(c + 1, MADV_WILLNEED);
+	// gates work on the mapped pages directly, all groups of the chunk
+	std::complex< double >* chunk = _data + c * _chunkSize;
+	for (int g = 0; g < batch.size(); ++g)
+	    KroneckerTensor::applyToSubsystems(batch[g].matrix, batch[g].subsystems, localDims, chunk, 0, _chunkSize);
+	_advise(c, MADV_DONTNEED); // pages stay in page cache or go to file, RAM of the process is released
+    }
+    ++_passes;
+}
+
+void MappedStateVector::_swapSlots(int global, int local)
+{
+    // amplitude with digits (i, j) in slots (global, local) moves to (j, i); global digit numbers chunks,
+    // so chunks with global digits i and j exchange runs of amplitudes with local digits j and i
+    long long dim = _slotDims[global], chunkStride = _slotStrides[global] / _chunkSize, run = _slotStrides[local];
+    for (long long c = 0; c < chunksCount(); ++c) {
+	if ((c / chunkStride) % dim != 0) continue;
+	for (long long i = 0; i < dim; ++i)
+	    for (long long j = i + 1; j < dim; ++j) {
+		std::complex< double >* first = _data + (c + i * chunkStride) * _chunkSize;
+		std::complex< double >* second = _data + (c + j * chunkStride) * _chunkSize;
+		for (long long base = 0; base < _chunkSize; base += run * dim)
+		    std::swap_ranges(first + base + j * run, first + base + (j + 1) * run, second + base + i * run);
+	    }
+	for (long long i = 0; i < dim; ++i)
+	    _advise(c + i * chunkStride, MADV_DONTNEED);
+    }
+    
+    int a = _subsystemIn[global], b = _subsystemIn[local];
+    std::swap(_subsystemIn[global], _subsystemIn[local]);
+    _slotOf[a] = local;
+    _slotOf[b] = global;
+    ++_swaps;
+}
+
+#endif
+
+#ifndef Getters
+
+std::complex< double > MappedStateVector::amplitude(const std::vector< int >& digits) const
+{
+    return _data[_index(digits)];
+}
+
+VectorXcd MappedStateVector::toVector() const
+{
+    VectorXcd res(_size);
+    std::vector< int > digits(_slotOf.size(), 0);
+    for (long long i = 0; i < _size; ++i) {
+	res[i] = _data[_index(digits)];
+	for (int s = (int) digits.size() - 1; s >= 0; --s) {
+	    if (++digits[s] < _slotDims[_slotOf[s]]) break;
+	    digits[s] = 0;
+	}
+    }
+    return res;
+}
+
+HilbertSpace MappedStateVector::space() const
+{
+    return HilbertSpace(_dimensions);
+}
+
+const std::vector< uint >& MappedStateVector::dimensions() const
+{
+    return _dimensions;
+}
+
+long long MappedStateVector::size() const
+{
+    return _size;
+}
+
+long long MappedStateVector::chunkSize() const
+{
+    return _chunkSize;
+}
+
+long long MappedStateVector::chunksCount() const
+{
+    return _size / _chunkSize;
+}
+
+std::vector< int > MappedStateVector::layout() const
+{
+    return _slotOf;
+}
+
+int MappedStateVector::passesCount() const
+{
+    return _passes;
+}
+
+int MappedStateVector::swapsCount() const
+{
+    return _swaps;
+}
+
+#endif
@@ -0,0 +1,121 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef MAPPED_STATE_VECTOR_H
+#define MAPPED_STATE_VECTOR_H
+
+#include "../Eigen/Core"
+#include "hilbert_space.h"
+#include "circuit.h"
+#include <complex>
+#include <string>
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * Out-of-core state vector stored in memory-mapped file, so that its size is limited by disk rather than RAM.
+ * Vector is split into chunks over the trailing (local) subsystem slots, the leading slots are global and number chunks.
+ * Gates acting on local slots only are applied chunk by chunk, one load of every chunk per batch of such gates.
+ * Global subsystem needed by a gate is exchanged with a local one by chunk swap, so the mapping from subsystems to
+ * slots changes while the circuit runs; amplitudes are always addressed by subsystems
+ */
+class MappedStateVector
+{
+public:
+    /**
+     * Create sparse file and put |0...0> into it. Total dimension may exceed int, only disk space limits it
+     * @param dimensions Dimensions of subsystems of the state
+     * @param path File to store amplitudes in, it is removed in destructor
+     * @param localSubsystems Count of trailing subsystems in chunk; must be not less than the widest gate
+     */
+    MappedStateVector(const std::vector< uint >& dimensions, const std::string& path, int localSubsystems);
+    ~MappedStateVector();
+    
+    /**
+     * Apply all gates of the circuit. Gates are reordered (only across gates on other subsystems) into batches of local
+     * gates; before a gate that needs global subsystem, the subsystem is swapped with the local one that will be needed
+     * latest
+     */
+    void apply(const Circuit& circuit);
+    
+    /**
+     * Amplitude of basis state given by digit of every subsystem
+     */
+    std::complex< double > amplitude(const std::vector< int >& digits) const;
+    
+    /**
+     * Whole vector in order of subsystems. Use it only for small spaces
+     */
+    VectorXcd toVector() const;
+    
+    /**
+     * Space of the state; throws for spaces whose total dimension does not fit in int, see dimensions()
+     */
+    HilbertSpace space() const;
+    const std::vector< uint >& dimensions() const;
+    long long size() const;
+    long long chunkSize() const;
+    long long chunksCount() const;
+    
+    /**
+     * Slot of every subsystem, slots from localSubsystems count from the end are local
+     */
+    std::vector< int > layout() const;
+    
+    /**
+     * Count of passes over all chunks made to apply gate batches
+     */
+    int passesCount() const;
+    
+    /**
+     * Count of chunk swaps made for global subsystems
+     */
+    int swapsCount() const;
+    
+private:
+    std::vector< uint > _dimensions;
+    std::string _path;
+    int _fd;
+    std::complex< double >* _data;
+    long long _size, _chunkSize;
+    int _firstLocal;
+    std::vector< uint > _slotDims;
+    std::vector< long long > _slotStrides;
+    std::vector< int > _slotOf, _subsystemIn;
+    int _passes, _swaps;
+    
+    void _applyBatch(const std::vector< CircuitGate >& batch);
+    void _swapSlots(int global, int local);
+    void _advise(long long chunk, int advice) const;
+    long long _index(const std::vector< int >& digits) const;
+    
+    // file and mapping are owned by the object
+    MappedStateVector(const MappedStateVector&);
+    MappedStateVector& operator=(const MappedStateVector&);
+};
+
+#endif // MAPPED_STATE_VECTOR_H
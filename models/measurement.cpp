@@ -29,6 +29,7 @@
 #include "kronecker_tensor.h"
 #include <stdexcept>
 #include <string>
+#include <algorithm>
 
 std::string i_to_string(int i)
 {
@@ -44,41 +45,101 @@ std::string i_to_string(int i)
 
 Measurement::Measurement()
 {
-    _err = "Operators set cannot be empty";
-    _valid = false;
+    _computationalBasis = false;
+    _validated = false;
 }
 
 Measurement::Measurement(std::vector<MatrixXcd> operators, std::vector<std::string> labels)
 {
     if (operators.size() != labels.size())
 	throw std::invalid_argument("Number of labels must be the same as operators");
-    _operators = operators;
+    for (int i = 0; i < operators.size(); ++i)
+	_operators.push_back(MeasurementOperator(operators[i]));
     _labels = labels;
-    _checkOperatorsAreValid();
+    _computationalBasis = false;
+    _validated = false;
 }
 
 Measurement::Measurement(MatrixXcd observable)
 {
     ComplexEigenSolver<MatrixXcd> solver(observable);
     MatrixXcd vectors = solver.eigenvectors();
-    for (int i = 0; i < vectors.cols(); ++i)
-	addOperator(vectors.col(i) * vectors.col(i).transpose(), i_to_string(i));    
-    _checkOperatorsAreValid();
+    for (int i = 0; i < vectors.cols(); ++i) {
+	_operators.push_back(MeasurementOperator::fromFactor(vectors.col(i)));
+	_labels.push_back(i_to_string(i));
+    }
+    _computationalBasis = false;
+    _validated = false;
 }
 
 void Measurement::addOperator(MatrixXcd matr, std::string label)
 {
-    _operators.push_back(matr);
+    if (_computationalBasis)
+	_materializeBasisOperators();
+    _operators.push_back(MeasurementOperator(matr));
     _labels.push_back(label);
-    _checkOperatorsAreValid();
+    _validated = false; // checks are expensive, so they run once before the first use
+}
+
+void Measurement::addOperator(const SparseMatrixXcd& matr, std::string label)
+{
+    if (_computationalBasis)
+	_materializeBasisOperators();
+    _operators.push_back(MeasurementOperator(matr));
+    _labels.push_back(label);
+    _validated = false;
+}
+
+void Measurement::addFactoredOperator(MatrixXcd factor, std::string label)
+{
+    if (_computationalBasis)
+	_materializeBasisOperators();
+    _operators.push_back(MeasurementOperator::fromFactor(factor));
+    _labels.push_back(label);
+    _validated = false;
+}
+
+void Measurement::_initComputationalBasis(const HilbertSpace& space)
+{
+    _operators.clear();
+    _labels.clear();
+    _computationalBasis = true;
+    _basisSpace = space;
+    _validated = false;
+}
+
+void Measurement::_materializeBasisOperators()
+{
+    for (int i = 0; i < _basisSpace.totalDimension(); ++i)
+	_operators.push_back(MeasurementOperator::fromFactor(_basisSpace.getBasisVector(_basisSpace.getVector(i))));
+    _labels = labels();
+    _computationalBasis = false;
 }
 
 #endif
 
 #ifndef Checks
 
+void Measurement::_validate()
+{
+    if (_validated) return;
+    _checkOperatorsAreValid();
+    _validated = true;
+}
+
 void Measurement::_checkOperatorsAreValid()
 {
+    if (_computationalBasis) { // projectors on basis vectors are valid by construction
+	_valid = _basisSpace.totalDimension() > 0;
+	if (!_valid) _err = "Operators set cannot be empty";
+	return;
+    }
+    if (_operators.empty()) {
+	_err = "Operators set cannot be empty";
+	_valid = false;
+	return;
+    }
+    
     if (true 
 	&& _checkOperatorsHaveTheSameSize()
 	&& _checkOperatorsSumEqualToIdentity()
@@ -93,24 +154,24 @@ void Measurement::_checkOperatorsAreValid()
 bool Measurement::_checkOperatorsHaveTheSameSize()
 {
     if (_operators.empty()) return true;
-    int size = _operators[0].cols();
+    int size = _operators[0].dimension();
     for (int i = 0; i < _operators.size(); ++i) {
-	if (_operators[i].cols() != _operators[i].rows()) 	{_err = "Operators must be square"; return false;}
-	if (_operators[i].cols() != size)			{_err = "All operators in one set must be the same size"; return false;}
+	if (!_operators[i].isSquare()) 			{_err = "Operators must be square"; return false;}
+	if (_operators[i].dimension() != size)		{_err = "All operators in one set must be the same size"; return false;}
     }
     return true;
 }
 
 bool Measurement::_checkOperatorsSumEqualToIdentity()
 {
-    MatrixXcd  identity(_operators[0].cols(), _operators[0].cols());
+    MatrixXcd  identity(_operators[0].dimension(), _operators[0].dimension());
     identity.setIdentity();
     
-    MatrixXcd res(_operators[0].cols(), _operators[0].cols());
+    MatrixXcd res(_operators[0].dimension(), _operators[0].dimension());
     res.setZero();
     
     for (int i = 0; i < _operators.size(); ++i)
-	res += _operators[i];
+	res += _operators[i].toDense();
     
     if (!res.isApprox(identity)) {
 	_err = "Operators sum must be equal to the identity operator";
@@ -122,7 +183,7 @@ bool Measurement::_checkOperatorsSumEqualToIdentity()
 bool Measurement::_checkOperatorsAreHermit()
 {
     for (int i = 0; i < _operators.size(); ++i)
-	if (_operators[i] != _operators[i].adjoint()) {
+	if (!_operators[i].isHermit()) {
 	    _err = "Operators must be Hermit";
 	    return false;
 	}
@@ -131,21 +192,17 @@ bool Measurement::_checkOperatorsAreHermit()
 
 bool Measurement::_checkOperatorsArePositive()
 {
-    for (int i = 0; i < _operators.size(); ++i) {	
-	SelfAdjointEigenSolver<MatrixXcd> solver(_operators[i]);
-	VectorXd values = solver.eigenvalues();
-	for (int j = 0; j < values.size(); ++j)
-	    if (values[j] < -1.0e-15) {
-		_err = "Operators must have non-negative eigen values";
-		return false;
-	    }
-    }
+    for (int i = 0; i < _operators.size(); ++i)
+	if (!_operators[i].isPositive()) {
+	    _err = "Operators must have non-negative eigen values";
+	    return false;
+	}
     return true;
 }
 
 void Measurement::_checkSpacesDimensionsMatches(HilbertSpace space, int subsystem)
 {
-    if (_operators[0].cols() != (subsystem == -1 ? space.totalDimension() : space.dimension(subsystem)))
+    if (_operatorsDimension() != (subsystem == -1 ? space.totalDimension() : space.dimension(subsystem)))
 	throw std::invalid_argument("State space dimension does not match operators dimension");
 }
 
@@ -153,57 +210,150 @@ void Measurement::_checkSpacesDimensionsMatches(HilbertSpace space, int subsyste
 
 #ifndef Performing
 
-MatrixXcd Measurement::_getMeasurementMatrix(int subsystem, int num, const HilbertSpace& space)
+MatrixXcd Measurement::_reducedDensity(const QuantumState& state, int subsystem)
 {
-    if (subsystem == -1)
-	return _operators[num];
+    // p_S(a,b) = sum over other indices k of <k,a|p|k,b>, indices of subsystem are taken by stride
+    const MatrixXcd& density = state.densityMatrix();
+    int dim = state.space().dimension(subsystem);
+    int stride = 1;
+    for (int i = subsystem + 1; i < state.space().rank(); ++i)
+	stride *= state.space().dimension(i);
+    int block = dim * stride;
     
-    return KroneckerTensor::expand(_operators[num], subsystem, space.dimensions());
+    MatrixXcd res(dim, dim);
+    res.setZero();
+    for (int outer = 0; outer < density.rows(); outer += block)
+	for (int inner = 0; inner < stride; ++inner)
+	    for (int b = 0; b < dim; ++b)
+		for (int a = 0; a < dim; ++a)
+		    res(a, b) += density(outer + a * stride + inner, outer + b * stride + inner);
+    return res;
 }
 
-std::map< std::string, double > Measurement::probabilities(const QuantumState& state, int subsystem)
+std::vector< double > Measurement::_probabilities(const QuantumState& state, int subsystem)
+{
+    if (_computationalBasis)
+	return _basisProbabilities(state, subsystem);
+    
+    // Tr(p * (I x M x I)) = Tr(p_S * M), so for subsystem only its reduced matrix is needed
+    MatrixXcd density = (subsystem == -1) ? state.densityMatrix() : _reducedDensity(state, subsystem);
+    std::vector< double > res(_operators.size());
+    for (int i = 0; i < _operators.size(); ++i)
+	res[i] = _operators[i].probability(density);
+    return res;
+}
+
+std::vector< double > Measurement::_basisProbabilities(const QuantumState& state, int subsystem)
+{
+    // probability of basis vector k is <k|p|k>; for subsystem sum it over all other indices
+    const MatrixXcd& density = state.densityMatrix();
+    int size = density.rows();
+    int dim = (subsystem == -1) ? size : state.space().dimension(subsystem);
+    int stride = 1;
+    if (subsystem != -1)
+	for (int i = subsystem + 1; i < state.space().rank(); ++i)
+	    stride *= state.space().dimension(i);
+    
+    std::vector< double > res(dim, 0);
+    for (int i = 0; i < size; ++i)
+	res[(i / stride) % dim] += density(i, i).real();
+    return res;
+}
+
+MatrixXcd Measurement::_collapseOnBasisVector(const QuantumState& state, int subsystem, int num, double probability)
 {
+    // p' = P p P / prob, where P = I x |num><num| x I just keeps rows and cols with subsystem index equal to num
+    MatrixXcd density = state.densityMatrix();
+    int size = density.rows();
+    int dim = (subsystem == -1) ? size : state.space().dimension(subsystem);
+    int stride = 1;
+    if (subsystem != -1)
+	for (int i = subsystem + 1; i < state.space().rank(); ++i)
+	    stride *= state.space().dimension(i);
+    
+    for (int col = 0; col < size; ++col) {
+	bool keepCol = (col / stride) % dim == num;
+	for (int row = 0; row < size; ++row)
+	    if (keepCol && (row / stride) % dim == num)
+		density(row, col) /= probability;
+	    else density(row, col) = 0;
+    }
+    return density;
+}
+
+std::vector< double > Measurement::outcomeProbabilities(const QuantumState& state, int subsystem)
+{
+    _validate();
     if (!_valid) 
 	throw std::runtime_error("You cannot test probabilities because " + _err);
     _checkSpacesDimensionsMatches(state.space(), subsystem);
     
+    return _probabilities(state, subsystem);
+}
+
+std::map< std::string, double > Measurement::probabilities(const QuantumState& state, int subsystem)
+{
+    std::vector< double > probs = outcomeProbabilities(state, subsystem);
     std::map< std::string, double > res;
-    for (int i = 0; i < _operators.size(); ++i) {
-	MatrixXcd measureMatr = _getMeasurementMatrix(subsystem, i, state.space());
-	res[_labels[i]] = (state.densityMatrix() * measureMatr).trace().real();
-    }
+    for (int i = 0; i < probs.size(); ++i)
+	res[label(i)] = probs[i];
     return res;
 }
 
 std::string Measurement::performOn(QuantumState* state, int subsystem)
 {
+    return label(performOutcome(state, _generator, subsystem));
+}
+
+std::string Measurement::performOn(QuantumState* state, RandomGenerator& generator, int subsystem)
+{
+    return label(performOutcome(state, generator, subsystem));
+}
+
+int Measurement::performOutcome(QuantumState* state, int subsystem)
+{
+    return performOutcome(state, _generator, subsystem);
+}
+
+int Measurement::performOutcome(QuantumState* state, RandomGenerator& generator, int subsystem)
+{
+    _validate();
     if (!_valid) 
 	throw std::runtime_error("You cannot perform this measurement because " + _err);
     _checkSpacesDimensionsMatches(state->space(), subsystem);
     
-    std::map< std::string, double > probs = probabilities(*state, subsystem);
+    std::vector< double > probs = _probabilities(*state, subsystem);
     
-    //srand(time(NULL));
-    double r = (double) rand() / RAND_MAX;
+    double r = generator.uniform();
     
     int outcomeNum = 0;
-    double probSum = probs[_labels[outcomeNum]];
+    double probSum = probs[outcomeNum];
     
-    while (r > probSum) 
-	probSum += probs[_labels[++outcomeNum]];
+    while (r >= probSum && outcomeNum < (int) probs.size() - 1) 
+	probSum += probs[++outcomeNum];
     
     // now in outcomeNum we have our outcome index
     // lets perform changing state
-    // first, we need to compute square root of operator
-    
-    MatrixXcd measureMatr = _getMeasurementMatrix(subsystem, outcomeNum, state->space());
-    SelfAdjointEigenSolver<MatrixXcd> solver(measureMatr);
-    MatrixXcd root = solver.operatorSqrt();
+    if (_computationalBasis) {
+	state->setMatrix(_collapseOnBasisVector(*state, subsystem, outcomeNum, probs[outcomeNum]));
+	return outcomeNum;
+    }
     
-    MatrixXcd newMatrix = (root * state->densityMatrix() * root) / probs[_labels[outcomeNum]];
-    state->setMatrix(newMatrix);
+    MatrixXcd newMatrix;
+    if (subsystem == -1)
+	newMatrix = _operators[outcomeNum].collapse(state->densityMatrix());
+    else {
+	// R = I x sqrt(M) x I is applied from both sides by subsystem without expanding: R * (R * p)^+ = R * p * R
+	MatrixXcd root = _operators[outcomeNum].sqrtMatrix();
+	std::vector<uint> dims = state->space().dimensions();
+	newMatrix = state->densityMatrix();
+	KroneckerTensor::applyToSubsystem(root, subsystem, dims, newMatrix);
+	newMatrix.adjointInPlace();
+	KroneckerTensor::applyToSubsystem(root, subsystem, dims, newMatrix);
+    }
+    state->setMatrix(newMatrix / probs[outcomeNum]);
     
-    return _labels[outcomeNum];
+    return outcomeNum;
 }
 
 std::string Measurement::performOnSubsystem(QuantumState* state, int subsystem)
@@ -219,43 +369,83 @@ std::string Measurement::performOnSubsystem(QuantumState* state, int subsystem)
 
 Proector::Proector(HilbertSpace space)
 {
-    for (int i = 0; i < space.totalDimension(); ++i) {
-	VectorXi toLabel = space.getVector(i);
-	VectorXcd op = space.getBasisVector(toLabel);
-	addOperator(op * op.transpose(), _vecToLabel(toLabel));
-    }
+    _initComputationalBasis(space);
 }
 
-std::string Proector::_vecToLabel(VectorXi vec)
+std::string Measurement::label(int outcome)
 {
-    std::string v = "";
-    for (int i = 0; i < vec.size(); ++i) {
+    if (outcome < 0 || outcome >= outcomesCount())
+	throw std::out_of_range("There is no outcome with such index");
+    if (!_computationalBasis)
+	return _labels[outcome];
+    
+    // digits are written directly, stringstream per basis vector is too slow for large spaces
+    std::string v;
+    for (int i = _basisSpace.rank() - 1; i >= 0; --i) {
+	int digit = outcome % _basisSpace.dimension(i);
+	outcome /= _basisSpace.dimension(i);
+	do {
+	    v += (char) ('0' + digit % 10);
+	    digit /= 10;
+	} while (digit > 0);
 	if (i != 0) v += ",";
-	v += i_to_string(vec[i]);
     }
+    std::reverse(v.begin(), v.end());
     return "|" + v + "><" + v + "|";
 }
 
+int Measurement::outcomesCount()
+{
+    return _computationalBasis ? _basisSpace.totalDimension() : _operators.size();
+}
 
+int Measurement::_operatorsDimension()
+{
+    return _computationalBasis ? _basisSpace.totalDimension() : _operators[0].dimension();
+}
 
 bool Measurement::isValid()
 {
+    _validate();
     return _valid;
 }
 
 std::vector< MatrixXcd > Measurement::operators()
 {
-    return _operators;
+    std::vector< MatrixXcd > res;
+    if (!_computationalBasis) {
+	for (int i = 0; i < _operators.size(); ++i)
+	    res.push_back(_operators[i].toDense());
+	return res;
+    }
+    
+    for (int i = 0; i < _basisSpace.totalDimension(); ++i) {
+	VectorXcd op = _basisSpace.getBasisVector(_basisSpace.getVector(i));
+	res.push_back(op * op.transpose());
+    }
+    return res;
 }
 
 std::string Measurement::error()
 {
+    _validate();
     return _err;
 }
 
 std::vector< std::string > Measurement::labels()
 {
-    return _labels;
+    if (!_computationalBasis)
+	return _labels;
+    
+    std::vector< std::string > res;
+    for (int i = 0; i < outcomesCount(); ++i)
+	res.push_back(label(i));
+    return res;
+}
+
+void Measurement::setRandomGenerator(const RandomGenerator& generator)
+{
+    _generator = generator;
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -29,6 +29,8 @@
 
 #include "../Eigen/Core"
 #include "quantum_state.h"
+#include "random_generator.h"
+#include "measurement_operator.h"
 #include <vector>
 #include <map>
 using namespace Eigen;
@@ -65,6 +67,21 @@ public:
      */
     void addOperator(MatrixXcd matr, std::string label);
     
+    /**
+     * Add one more operator stored as sparse matrix. Probabilities are computed from its non-zero elements only
+     * @param matr Operator matrix. Should be Hermit and positive-defined
+     * @param label Label of outcome that corresponds to this operator
+     */
+    void addOperator(const SparseMatrixXcd& matr, std::string label);
+    
+    /**
+     * Add one more operator V * V^+ stored as its factor. E.g. for POVM element built from ket |v> pass just v.
+     * Such operators take N times less memory and probabilities are computed in O(N^2)
+     * @param factor N x k matrix V
+     * @param label Label of outcome that corresponds to this operator
+     */
+    void addFactoredOperator(MatrixXcd factor, std::string label);
+    
     /**
      * Show if everything is OK during construct. You should check it before testing probabilities() or perfoming measurement
      * If smth wrong, the error may be retrieved through error().
@@ -99,7 +116,39 @@ public:
      */
     std::string performOn(QuantumState* state, int subsystem = -1);
     
+    /**
+     * Perform this measurement on the specified state drawing randomness from the specified generator.
+     * Use it with RandomGenerator::split() to get reproducible results when measuring from several threads
+     * @param state Quantum state to perform measurement on. Be sure about space matching
+     * @param generator Random generator used to choose the outcome
+     * @param subsystem -1 if measurement assigned to full state, or subsystem index
+     * @return Label of outcome which occured. Notice that state has changed
+     */
+    std::string performOn(QuantumState* state, RandomGenerator& generator, int subsystem = -1);
+    
     std::string performOnSubsystem(QuantumState* state, int subsystem);
+    
+    /**
+     * Same as probabilities(), but outcomes are identified by index, so no labels are created
+     * @return Vector where i-th value is probability of outcome i
+     */
+    std::vector<double> outcomeProbabilities(const QuantumState& state, int subsystem = -1);
+    
+    /**
+     * Same as performOn(), but returns index of outcome which occured. Use label() to get its label if needed
+     */
+    int performOutcome(QuantumState* state, int subsystem = -1);
+    int performOutcome(QuantumState* state, RandomGenerator& generator, int subsystem = -1);
+    
+    /**
+     * Number of possible outcomes
+     */
+    int outcomesCount();
+    
+    /**
+     * Label of outcome with specified index
+     */
+    std::string label(int outcome);
 
     /**
      * Full operator set of this measurement
@@ -111,28 +160,54 @@ public:
      */
     std::vector<std::string> labels();
     
+    /**
+     * Replace generator used by performOn() without explicit generator. By default it is seeded with 0
+     */
+    void setRandomGenerator(const RandomGenerator& generator);
+    
+protected:
+    /**
+     * Turn this measurement into the measurement in computational basis of the space. Assume to be called only in derived class
+     */
+    void _initComputationalBasis(const HilbertSpace& space);
+    
 private:
-    std::vector<MatrixXcd> _operators;
+    std::vector<MeasurementOperator> _operators;
     std::vector<std::string> _labels;
+    bool _validated;
     bool _valid;
     std::string _err;
+    RandomGenerator _generator;
+    
+    // outcome k of computational basis measurement is "basis vector k of _basisSpace".
+    // Operators and labels of such measurement are not stored, they are generated only on request
+    bool _computationalBasis;
+    HilbertSpace _basisSpace;
         
     void _checkOperatorsAreValid();
+    void _validate();
     bool _checkOperatorsHaveTheSameSize();
     bool _checkOperatorsSumEqualToIdentity();
     bool _checkOperatorsAreHermit();
     bool _checkOperatorsArePositive();
     void _checkSpacesDimensionsMatches(HilbertSpace space, int subsystem);
-    MatrixXcd _getMeasurementMatrix(int subsystem, int i, const HilbertSpace& space);
+    int _operatorsDimension();
+    void _materializeBasisOperators();
+    std::vector<double> _probabilities(const QuantumState& state, int subsystem);
+    std::vector<double> _basisProbabilities(const QuantumState& state, int subsystem);
+    MatrixXcd _collapseOnBasisVector(const QuantumState& state, int subsystem, int num, double probability);
+    MatrixXcd _reducedDensity(const QuantumState& state, int subsystem);
     MatrixXcd _getIdentityMatrix(int dimension);
 };
 
 
+/**
+ * Projective measurement in the computational basis of the space. Outcome k means "state collapsed to basis vector k".
+ * Projectors are not constructed: probabilities are just diagonal of density matrix
+ */
 class Proector : public Measurement
 {
 public:
     Proector(HilbertSpace space);
-private:
-    std::string _vecToLabel(VectorXi vec);
 };
 #endif // MEASUREMENT_H
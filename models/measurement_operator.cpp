@@ -0,0 +1,197 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "measurement_operator.h"
+#include "../Eigen/Eigenvalues"
+
+#ifndef Constructors
+
+MeasurementOperator::MeasurementOperator()
+{
+    
+}
+
+MeasurementOperator::MeasurementOperator(const MatrixXcd& matr)
+{
+    _representation = Dense;
+    _dense = matr;
+}
+
+MeasurementOperator::MeasurementOperator(const SparseMatrixXcd& matr)
+{
+    _representation = Sparse;
+    _sparse = matr;
+    _sparse.makeCompressed();
+}
+
+MeasurementOperator MeasurementOperator::fromFactor(const MatrixXcd& factor)
+{
+    MeasurementOperator op;
+    op._representation = Factored;
+    op._dense = factor;
+    return op;
+}
+
+#endif
+
+#ifndef Performing
+
+double MeasurementOperator::probability(const MatrixXcd& density) const
+{
+    switch (_representation) {
+	case Factored: // sum of v^+ * p * v over columns
+	    return (density * _dense).cwiseProduct(_dense.conjugate()).sum().real();
+	case Sparse: {
+	    std::complex< double > res = 0;
+	    for (int col = 0; col < _sparse.outerSize(); ++col)
+		for (SparseMatrixXcd::InnerIterator it(_sparse, col); it; ++it)
+		    res += it.value() * density(it.col(), it.row());
+	    return res.real();
+	}
+	default: // Tr(p * M) = sum p_ij * M_ji, no need in the full product
+	    return density.cwiseProduct(_dense.transpose()).sum().real();
+    }
+}
+
+MatrixXcd MeasurementOperator::collapse(const MatrixXcd& density) const
+{
+    if (_representation == Factored) {
+	// sqrt(V * V^+) = W * V^+ where W = V * (V^+ * V)^(-1/2), so the result is W * (V^+ * p * V) * W^+
+	MatrixXcd w = _factorRootFactor();
+	MatrixXcd reduced = _dense.adjoint() * density * _dense;
+	return w * reduced * w.adjoint();
+    }
+    if (_representation == Sparse && _sparseIsDiagonal()) {
+	VectorXcd root(dimension()); root.setZero();
+	for (int col = 0; col < _sparse.outerSize(); ++col)
+	    for (SparseMatrixXcd::InnerIterator it(_sparse, col); it; ++it)
+		root[col] = sqrt(it.value().real());
+	return root.asDiagonal() * density * root.asDiagonal();
+    }
+    MatrixXcd root = sqrtMatrix();
+    return root * density * root;
+}
+
+MatrixXcd MeasurementOperator::sqrtMatrix() const
+{
+    if (_representation == Factored)
+	return _factorRootFactor() * _dense.adjoint();
+    // zero eigen values may come out as +-1e-17, their root must be zero rather than NaN or 1e-8
+    SelfAdjointEigenSolver<MatrixXcd> solver(toDense());
+    VectorXd values = solver.eigenvalues();
+    double cutoff = 1.0e-12 * values.cwiseAbs().maxCoeff();
+    VectorXcd roots(values.size());
+    for (int i = 0; i < values.size(); ++i)
+	roots[i] = values[i] > cutoff ? sqrt(values[i]) : 0;
+    return solver.eigenvectors() * roots.asDiagonal() * solver.eigenvectors().adjoint();
+}
+
+MatrixXcd MeasurementOperator::_factorRootFactor() const
+{
+    // Gram matrix is only k x k, so its inverse square root is cheap; zero eigen values are skipped (pseudo-inverse)
+    SelfAdjointEigenSolver<MatrixXcd> solver(_dense.adjoint() * _dense);
+    VectorXd values = solver.eigenvalues();
+    VectorXcd inverseRoots(values.size());
+    for (int i = 0; i < values.size(); ++i)
+	inverseRoots[i] = values[i] > 1.0e-14 ? 1 / sqrt(values[i]) : 0;
+    return _dense * (solver.eigenvectors() * inverseRoots.asDiagonal() * solver.eigenvectors().adjoint());
+}
+
+#endif
+
+#ifndef Checks
+
+bool MeasurementOperator::isSquare() const
+{
+    switch (_representation) {
+	case Factored:
+	    return true;
+	case Sparse:
+	    return _sparse.rows() == _sparse.cols();
+	default:
+	    return _dense.rows() == _dense.cols();
+    }
+}
+
+bool MeasurementOperator::isHermit() const
+{
+    switch (_representation) {
+	case Factored:
+	    return true;
+	case Sparse:
+	    return SparseMatrixXcd(_sparse - SparseMatrixXcd(_sparse.adjoint())).norm() == 0;
+	default:
+	    return _dense == _dense.adjoint();
+    }
+}
+
+bool MeasurementOperator::isPositive() const
+{
+    if (_representation == Factored)
+	return true;
+    SelfAdjointEigenSolver<MatrixXcd> solver(toDense());
+    VectorXd values = solver.eigenvalues();
+    for (int j = 0; j < values.size(); ++j)
+	if (values[j] < -1.0e-15)
+	    return false;
+    return true;
+}
+
+bool MeasurementOperator::_sparseIsDiagonal() const
+{
+    for (int col = 0; col < _sparse.outerSize(); ++col)
+	for (SparseMatrixXcd::InnerIterator it(_sparse, col); it; ++it)
+	    if (it.row() != col) return false;
+    return true;
+}
+
+#endif
+
+#ifndef Getters
+
+MeasurementOperator::Representation MeasurementOperator::representation() const
+{
+    return _representation;
+}
+
+int MeasurementOperator::dimension() const
+{
+    return _representation == Sparse ? _sparse.rows() : _dense.rows();
+}
+
+MatrixXcd MeasurementOperator::toDense() const
+{
+    switch (_representation) {
+	case Factored:
+	    return _dense * _dense.adjoint();
+	case Sparse:
+	    return MatrixXcd(_sparse);
+	default:
+	    return _dense;
+    }
+}
+
+#endif
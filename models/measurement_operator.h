@@ -0,0 +1,106 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef MEASUREMENT_OPERATOR_H
+#define MEASUREMENT_OPERATOR_H
+
+#include "../Eigen/Core"
+#include "../Eigen/SparseCore"
+#include <complex>
+
+using namespace Eigen;
+
+typedef SparseMatrix< std::complex< double > > SparseMatrixXcd;
+
+/**
+ * One operator of general measurement stored in the form that is the cheapest for it:
+ * dense matrix, rank-k factor V (operator is V * V^+) or sparse matrix.
+ * Probability and collapse use the stored form, e.g. Tr(p * v * v^+) = v^+ * p * v costs O(N^2) instead of O(N^3)
+ */
+class MeasurementOperator
+{
+public:
+    enum Representation {Dense, Factored, Sparse};
+    
+    /**
+     * Construct operator stored as dense matrix
+     */
+    MeasurementOperator(const MatrixXcd& matr);
+    
+    /**
+     * Construct operator stored as sparse matrix
+     */
+    MeasurementOperator(const SparseMatrixXcd& matr);
+    
+    /**
+     * Construct operator V * V^+ stored as its factor V. Rank-1 projector |v><v| is just one column v
+     * @param factor N x k matrix V
+     */
+    static MeasurementOperator fromFactor(const MatrixXcd& factor);
+    
+    Representation representation() const;
+    
+    /**
+     * Size of the operator matrix (it is always square)
+     */
+    int dimension() const;
+    
+    /**
+     * Returns operator as dense matrix
+     */
+    MatrixXcd toDense() const;
+    
+    /**
+     * Returns Tr(density * M) -- probability of this outcome
+     */
+    double probability(const MatrixXcd& density) const;
+    
+    /**
+     * Returns unnormalized state after outcome occured: sqrt(M) * density * sqrt(M)
+     */
+    MatrixXcd collapse(const MatrixXcd& density) const;
+    
+    /**
+     * Returns dense square root of the operator
+     */
+    MatrixXcd sqrtMatrix() const;
+    
+    bool isSquare() const;
+    bool isHermit() const;
+    bool isPositive() const;
+    
+private:
+    MeasurementOperator();
+    
+    Representation _representation;
+    MatrixXcd _dense; // dense matrix or factor V
+    SparseMatrixXcd _sparse;
+    
+    MatrixXcd _factorRootFactor() const;
+    bool _sparseIsDiagonal() const;
+};
+
+#endif // MEASUREMENT_OPERATOR_H
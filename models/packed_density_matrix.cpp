@@ -0,0 +1,196 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "packed_density_matrix.h"
+#include "kronecker_tensor.h"
+#include <stdexcept>
+
+#ifndef Constructors
+
+PackedDensityMatrix::PackedDensityMatrix(const HilbertSpace& space)
+{
+    _space = space;
+    _dimension = space.totalDimension();
+    _packed = VectorXcd::Zero(packedSize(_dimension));
+    _packed[0] = 1;
+}
+
+PackedDensityMatrix::PackedDensityMatrix(const MatrixXcd& density, const HilbertSpace& space)
+{
+    if (density.rows() != space.totalDimension() || density.cols() != density.rows())
+	throw std::invalid_argument("Space total dimension shold be the same as matrix is");
+    _space = space;
+    _dimension = space.totalDimension();
+    _packed.resize(packedSize(_dimension));
+    for (int col = 0; col < _dimension; ++col)
+	_packed.segment(_index(0, col), col + 1) = density.col(col).head(col + 1);
+}
+
+PackedDensityMatrix::PackedDensityMatrix(const QuantumState& state)
+{
+    *this = PackedDensityMatrix(state.densityMatrix(), state.space());
+}
+
+#endif
+
+#ifndef Performing
+
+void PackedDensityMatrix::apply(const MatrixXcd& op, const std::vector< int >& subsystems)
+{
+    std::vector< uint > dims = _space.dimensions();
+    std::vector< long long > strides(dims.size(), 1);
+    for (int i = (int) dims.size() - 2; i >= 0; --i)
+	strides[i] = strides[i + 1] * dims[i + 1];
+    int localDim = KroneckerTensor::localDimension(subsystems, dims);
+    if (op.rows() != localDim || op.cols() != localDim)
+	throw std::invalid_argument("Operator size does not match subsystems dimensions");
+    
+    std::vector< int > offsets(localDim, 0);
+    for (int a = 0; a < localDim; ++a) {
+	int rest = a;
+	for (int i = (int) subsystems.size() - 1; i >= 0; --i) {
+	    offsets[a] += (rest % dims[subsystems[i]]) * strides[subsystems[i]];
+	    rest /= dims[subsystems[i]];
+	}
+    }
+    std::vector< int > bases;
+    for (int base = 0; base < _dimension; ++base) {
+	bool isBase = true; // all digits of subsystems are zero
+	for (int i = 0; i < subsystems.size() && isBase; ++i)
+	    isBase = (base / strides[subsystems[i]]) % dims[subsystems[i]] == 0;
+	if (isBase) bases.push_back(base);
+    }
+    
+    // block (r, c) of p goes to U * p_rc * U^+; block (c, r) is its adjoint, so pairs r <= c cover the matrix
+    MatrixXcd block(localDim, localDim), res(localDim, localDim);
+    MatrixXcd adjoint = op.adjoint();
+    for (int c = 0; c < bases.size(); ++c)
+	for (int r = 0; r <= c; ++r) {
+	    for (int b = 0; b < localDim; ++b)
+		for (int a = 0; a < localDim; ++a)
+		    block(a, b) = element(bases[r] + offsets[a], bases[c] + offsets[b]);
+	    res.noalias() = op * block * adjoint;
+	    for (int b = 0; b < localDim; ++b)
+		for (int a = 0; a < localDim; ++a)
+		    _set(bases[r] + offsets[a], bases[c] + offsets[b], res(a, b));
+	}
+}
+
+PackedDensityMatrix PackedDensityMatrix::partialTrace(int index) const
+{
+    if (index < 0) throw std::invalid_argument("You cannot take partial trace on negative subsystem index");
+    if (index >= _space.rank()) throw std::invalid_argument("This state have not such subsystem");
+    
+    std::vector< uint > dims = _space.dimensions();
+    dims.erase(dims.begin() + index);
+    HilbertSpace newSpace(dims);
+    PackedDensityMatrix res(newSpace);
+    res._packed.setZero();
+    
+    // reduced index i is split around traced digit k: full index is (i / low * dim + k) * low + i % low
+    int dim = _space.dimension(index);
+    int low = 1;
+    for (int i = index + 1; i < _space.rank(); ++i)
+	low *= _space.dimension(i);
+    for (int col = 0; col < res._dimension; ++col)
+	for (int row = 0; row <= col; ++row) {
+	    std::complex< double > sum = 0;
+	    for (int k = 0; k < dim; ++k)
+		sum += element((row / low * dim + k) * low + row % low, (col / low * dim + k) * low + col % low);
+	    res._packed[_index(row, col)] = sum;
+	}
+    return res;
+}
+
+#endif
+
+#ifndef Getters
+
+double PackedDensityMatrix::purity() const
+{
+    double res = 0;
+    for (int col = 0; col < _dimension; ++col) {
+	res += 2 * _packed.segment(_index(0, col), col).squaredNorm();
+	res += std::norm(_packed[_index(col, col)]);
+    }
+    return res;
+}
+
+VectorXd PackedDensityMatrix::probabilities() const
+{
+    VectorXd res(_dimension);
+    for (int i = 0; i < _dimension; ++i)
+	res[i] = _packed[_index(i, i)].real();
+    return res;
+}
+
+std::complex< double > PackedDensityMatrix::element(int row, int col) const
+{
+    return row <= col ? _packed[_index(row, col)] : std::conj(_packed[_index(col, row)]);
+}
+
+MatrixXcd PackedDensityMatrix::densityMatrix() const
+{
+    MatrixXcd res(_dimension, _dimension);
+    for (int col = 0; col < _dimension; ++col) {
+	res.col(col).head(col + 1) = _packed.segment(_index(0, col), col + 1);
+	res.row(col).head(col) = _packed.segment(_index(0, col), col).adjoint();
+    }
+    return res;
+}
+
+QuantumState PackedDensityMatrix::toQuantumState() const
+{
+    return QuantumState(densityMatrix(), _space);
+}
+
+const VectorXcd& PackedDensityMatrix::packed() const
+{
+    return _packed;
+}
+
+HilbertSpace PackedDensityMatrix::space() const
+{
+    return _space;
+}
+
+long long PackedDensityMatrix::packedSize(int dimension)
+{
+    return (long long) dimension * (dimension + 1) / 2;
+}
+
+long long PackedDensityMatrix::_index(int row, int col)
+{
+    return (long long) col * (col + 1) / 2 + row;
+}
+
+void PackedDensityMatrix::_set(int row, int col, const std::complex< double >& value)
+{
+    if (row <= col) _packed[_index(row, col)] = value;
+    else _packed[_index(col, row)] = std::conj(value);
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef PACKED_DENSITY_MATRIX_H
+#define PACKED_DENSITY_MATRIX_H
+
+#include "../Eigen/Core"
+#include "hilbert_space.h"
+#include "quantum_state.h"
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * Density matrix that stores only its upper triangle, packed by columns: element (i, j), i <= j, is at j*(j+1)/2 + i.
+ * Lower elements are conjugates of upper ones and are never stored, so memory and traffic are about half of the
+ * full matrix. Gates, partial trace, purity and probabilities work on the packed array; full matrix is built only
+ * by densityMatrix()
+ */
+class PackedDensityMatrix
+{
+public:
+    /**
+     * State |0...0><0...0| of space
+     */
+    PackedDensityMatrix(const HilbertSpace& space);
+    
+    /**
+     * Pack upper triangle of matrix, lower one is not read
+     */
+    PackedDensityMatrix(const MatrixXcd& density, const HilbertSpace& space);
+    PackedDensityMatrix(const QuantumState& state);
+    
+    /**
+     * p = U * p * U^+ for operator on listed subsystems. Only blocks on and above diagonal are transformed
+     */
+    void apply(const MatrixXcd& op, const std::vector< int >& subsystems);
+    
+    /**
+     * Trace out subsystem, see QuantumState::partialTrace()
+     */
+    PackedDensityMatrix partialTrace(int index) const;
+    
+    /**
+     * Tr(p^2), off-diagonal elements are counted twice
+     */
+    double purity() const;
+    
+    /**
+     * Probabilities of computational basis states, real part of diagonal
+     */
+    VectorXd probabilities() const;
+    
+    std::complex< double > element(int row, int col) const;
+    
+    /**
+     * Build full Hermit matrix (allocates N^2)
+     */
+    MatrixXcd densityMatrix() const;
+    QuantumState toQuantumState() const;
+    
+    const VectorXcd& packed() const;
+    HilbertSpace space() const;
+    
+    static long long packedSize(int dimension);
+    
+private:
+    VectorXcd _packed;
+    HilbertSpace _space;
+    int _dimension;
+    
+    static long long _index(int row, int col);
+    void _set(int row, int col, const std::complex< double >& value);
+};
+
+#endif // PACKED_DENSITY_MATRIX_H
@@ -0,0 +1,179 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "path_sum.h"
+#include "work_stealing.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+PathSum::PathSum(const Circuit& circuit, int threads, double tolerance) : _circuit(circuit)
+{
+    _threads = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    const std::vector< uint >& dims = circuit.dimensions();
+    _lastGate.assign(circuit.rank(), -1);
+    for (int g = 0; g < circuit.gatesCount(); ++g) {
+	const CircuitGate& gate = circuit.gate(g);
+	std::vector< int > strides(gate.subsystems.size(), 1);
+	for (int i = (int) gate.subsystems.size() - 2; i >= 0; --i)
+	    strides[i] = strides[i + 1] * dims[gate.subsystems[i + 1]];
+	_localStrides.push_back(strides);
+	
+	std::vector< std::vector< Element > > columns(gate.matrix.cols());
+	for (int in = 0; in < gate.matrix.cols(); ++in)
+	    for (int out = 0; out < gate.matrix.rows(); ++out)
+		if (abs(gate.matrix(out, in)) > tolerance) {
+		    Element e = {out, gate.matrix(out, in)};
+		    columns[in].push_back(e);
+		}
+	_columns.push_back(columns);
+	for (int i = 0; i < gate.subsystems.size(); ++i)
+	    _lastGate[gate.subsystems[i]] = g;
+    }
+}
+
+int PathSum::branchingGatesCount() const
+{
+    int count = 0;
+    for (int g = 0; g < _columns.size(); ++g) {
+	bool branching = false;
+	for (int in = 0; in < _columns[g].size() && !branching; ++in)
+	    branching = _columns[g][in].size() > 1;
+	count += branching;
+    }
+    return count;
+}
+
+void PathSum::_checkDigits(const std::vector< int >& digits) const
+{
+    const std::vector< uint >& dims = _circuit.dimensions();
+    if (digits.size() != _circuit.rank())
+	throw std::invalid_argument("Basis state must have digit for every subsystem");
+    for (int s = 0; s < digits.size(); ++s)
+	if (digits[s] < 0 || digits[s] >= dims[s])
+	    throw std::invalid_argument("Digit is out of subsystem dimension");
+}
+
+bool PathSum::_allowed(int gate, int output, const std::vector< int >& outcome) const
+{
+    const std::vector< int >& subs = _circuit.gate(gate).subsystems;
+    for (int i = 0; i < subs.size(); ++i)
+	if (_lastGate[subs[i]] == gate && (output / _localStrides[gate][i]) % _circuit.dimensions()[subs[i]] != outcome[subs[i]])
+	    return false;
+    return true;
+}
+
+std::complex< double > PathSum::_walk(int gate, std::vector< int >& digits, std::complex< double > weight, const std::vector< int >& outcome) const
+{
+    // subsystems are fixed to outcome by their last gates, so complete path always ends in outcome
+    if (gate == _columns.size())
+	return weight;
+    
+    const std::vector< int >& subs = _circuit.gate(gate).subsystems;
+    const std::vector< int >& strides = _localStrides[gate];
+    int in = 0;
+    for (int i = 0; i < subs.size(); ++i)
+	in += digits[subs[i]] * strides[i];
+    
+    std::complex< double > sum = 0;
+    const std::vector< Element >& column = _columns[gate][in];
+    for (int e = 0; e < column.size(); ++e) {
+	if (!_allowed(gate, column[e].output, outcome)) continue;
+	for (int i = 0; i < subs.size(); ++i)
+	    digits[subs[i]] = (column[e].output / strides[i]) % _circuit.dimensions()[subs[i]];
+	sum += _walk(gate + 1, digits, weight * column[e].value, outcome);
+    }
+    for (int i = 0; i < subs.size(); ++i)
+	digits[subs[i]] = (in / strides[i]) % _circuit.dimensions()[subs[i]];
+    return sum;
+}
+
+void PathSum::_expand(const Prefix& prefix, const std::vector< int >& outcome, std::vector< Prefix >& children) const
+{
+    if (prefix.gate == _columns.size()) {
+	children.push_back(prefix);
+	return;
+    }
+    const std::vector< int >& subs = _circuit.gate(prefix.gate).subsystems;
+    const std::vector< int >& strides = _localStrides[prefix.gate];
+    int in = 0;
+    for (int i = 0; i < subs.size(); ++i)
+	in += prefix.digits[subs[i]] * strides[i];
+    const std::vector< Element >& column = _columns[prefix.gate][in];
+    for (int e = 0; e < column.size(); ++e) {
+	if (!_allowed(prefix.gate, column[e].output, outcome)) continue;
+	Prefix child = {prefix.gate + 1, prefix.digits, prefix.weight * column[e].value};
+	for (int i = 0; i < subs.size(); ++i)
+	    child.digits[subs[i]] = (column[e].output / strides[i]) % _circuit.dimensions()[subs[i]];
+	children.push_back(child);
+    }
+}
+
+std::complex< double > PathSum::amplitude(const std::vector< int >& outcome, const std::vector< int >& input) const
+{
+    _checkDigits(outcome);
+    _checkDigits(input);
+    for (int s = 0; s < outcome.size(); ++s)
+	if (_lastGate[s] < 0 && outcome[s] != input[s])
+	    return 0;
+    
+    // breadth-first expansion gives enough prefixes to keep every thread busy; their count does not depend on threads
+    // count, so neither does the order of summation
+    Prefix root = {0, input, 1};
+    std::vector< Prefix > prefixes(1, root);
+    while (prefixes.size() < _prefixesCount && prefixes[0].gate < _columns.size()) {
+	std::vector< Prefix > children;
+	for (int p = 0; p < prefixes.size(); ++p)
+	    _expand(prefixes[p], outcome, children);
+	prefixes.swap(children);
+	if (prefixes.empty()) return 0;
+    }
+    
+    // every prefix has its own slot of results, so no locks are needed
+    std::vector< std::complex< double > > results(prefixes.size());
+    runWorkStealing(prefixes.size(), _threads, [&](int, int task) {
+	std::vector< int > digits = prefixes[task].digits;
+	results[task] = _walk(prefixes[task].gate, digits, prefixes[task].weight, outcome);
+    });
+    
+    std::complex< double > sum = 0;
+    for (int p = 0; p < results.size(); ++p)
+	sum += results[p];
+    return sum;
+}
+
+std::complex< double > PathSum::amplitude(const std::vector< int >& outcome) const
+{
+    return amplitude(outcome, std::vector< int >(outcome.size(), 0));
+}
+
+std::vector< std::complex< double > > PathSum::amplitudes(const std::vector< std::vector< int > >& outcomes) const
+{
+    std::vector< std::complex< double > > res;
+    for (int i = 0; i < outcomes.size(); ++i)
+	res.push_back(amplitude(outcomes[i]));
+    return res;
+}
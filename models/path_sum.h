@@ -0,0 +1,95 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef PATH_SUM_H
+#define PATH_SUM_H
+
+#include "circuit.h"
+#include <complex>
+#include <vector>
+
+/**
+ * Feynman path-sum engine: amplitude <x|C|y> is the sum over sequences of intermediate basis states of products of gate
+ * elements. Paths are walked depth-first, so memory is O(subsystems * gates) whatever the space size.
+ * Every column of gate is stored as list of its nonzero elements, so permutation and diagonal gates do not branch;
+ * the last gate on every subsystem takes only outputs equal to digit of x.
+ * Path prefixes are shared between threads, idle threads steal prefixes from the others (see runWorkStealing())
+ */
+class PathSum
+{
+public:
+    /**
+     * @param circuit Circuit to be simulated
+     * @param threads Count of worker threads, 0 means hardware concurrency
+     * @param tolerance Gate elements with absolute value below it are treated as zero
+     */
+    PathSum(const Circuit& circuit, int threads = 0, double tolerance = 1.0e-14);
+    
+    /**
+     * Amplitude <outcome| C |0...0>
+     * @param outcome Basis state digit for every subsystem
+     */
+    std::complex< double > amplitude(const std::vector< int >& outcome) const;
+    
+    /**
+     * Amplitude <outcome| C |input>
+     */
+    std::complex< double > amplitude(const std::vector< int >& outcome, const std::vector< int >& input) const;
+    
+    std::vector< std::complex< double > > amplitudes(const std::vector< std::vector< int > >& outcomes) const;
+    
+    /**
+     * Count of gates that have column with several nonzero elements, paths branch only on them
+     */
+    int branchingGatesCount() const;
+    
+private:
+    struct Element
+    {
+	int output;
+	std::complex< double > value;
+    };
+    struct Prefix
+    {
+	int gate;
+	std::vector< int > digits;
+	std::complex< double > weight;
+    };
+    
+    static const int _prefixesCount = 256;
+    Circuit _circuit;
+    int _threads;
+    std::vector< std::vector< std::vector< Element > > > _columns; // for every gate and local input
+    std::vector< std::vector< int > > _localStrides;
+    std::vector< int > _lastGate; // for every subsystem, -1 if untouched
+    
+    void _checkDigits(const std::vector< int >& digits) const;
+    bool _allowed(int gate, int output, const std::vector< int >& outcome) const;
+    std::complex< double > _walk(int gate, std::vector< int >& digits, std::complex< double > weight, const std::vector< int >& outcome) const;
+    void _expand(const Prefix& prefix, const std::vector< int >& outcome, std::vector< Prefix >& children) const;
+};
+
+#endif // PATH_SUM_H
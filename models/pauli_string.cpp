@@ -0,0 +1,357 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "pauli_string.h"
+#include "kronecker_tensor.h"
+#include "transforms/hadamardgate.h"
+#include "transforms/phaseshiftgate.h"
+#include <stdexcept>
+
+namespace {
+const std::complex< double > powersOfI[4] = { std::complex< double >(1, 0), std::complex< double >(0, 1), std::complex< double >(-1, 0), std::complex< double >(0, -1) };
+
+inline double parity(uint64_t bits)
+{
+    return (__builtin_popcountll(bits) & 1) ? -1 : 1;
+}
+}
+
+#ifndef Constructors
+
+PauliString::PauliString(const std::string& paulis, std::complex< double > coefficient)
+{
+    if (paulis.size() > 64)
+	throw std::invalid_argument("Pauli string can hold at most 64 qubits");
+    _qubits = paulis.size();
+    _x = _z = 0;
+    _phase = 0;
+    _coefficient = coefficient;
+    for (int q = 0; q < _qubits; ++q) {
+	uint64_t bit = (uint64_t) 1 << (_qubits - 1 - q);
+	switch (paulis[q]) {
+	    case 'I': break;
+	    case 'X': _x |= bit; break;
+	    case 'Z': _z |= bit; break;
+	    case 'Y': _x |= bit; _z |= bit; ++_phase; break; // Y = i * X * Z
+	    default: throw std::invalid_argument("Pauli string may contain only I, X, Y and Z");
+	}
+    }
+    _phase %= 4;
+}
+
+PauliString::PauliString(uint64_t xMask, uint64_t zMask, int qubits, std::complex< double > coefficient)
+{
+    if (qubits < 0 || qubits > 64)
+	throw std::invalid_argument("Pauli string can hold at most 64 qubits");
+    if (qubits < 64 && ((xMask | zMask) >> qubits) != 0)
+	throw std::invalid_argument("Masks have bits outside of qubits range");
+    _qubits = qubits;
+    _x = xMask;
+    _z = zMask;
+    _phase = __builtin_popcountll(xMask & zMask) % 4;
+    _coefficient = coefficient;
+}
+
+#endif
+
+#ifndef Expectation
+
+std::complex< double > PauliString::_factor() const
+{
+    return _coefficient * powersOfI[_phase];
+}
+
+void PauliString::_checkSize(int size) const
+{
+    if (_qubits >= 63 || size != ((int64_t) 1 << _qubits))
+	throw std::invalid_argument("State size does not match number of qubits of Pauli string");
+}
+
+std::complex< double > PauliString::expectation(const VectorXcd& vec) const
+{
+    _checkSize(vec.size());
+    // <psi|P|psi> = sum over j of conj(psi_(j^x)) * (-1)^|j&z| * psi_j
+    std::complex< double > res = 0;
+    for (uint64_t j = 0; j < vec.size(); ++j)
+	res += parity(j & _z) * std::conj(vec[j ^ _x]) * vec[j];
+    return res * _factor();
+}
+
+std::complex< double > PauliString::expectation(const QuantumState& state) const
+{
+    HilbertSpace space = state.space();
+    for (int i = 0; i < space.rank(); ++i)
+	if (space.dimension(i) != 2)
+	    throw std::invalid_argument("Pauli strings can be measured only on qubits");
+    if (space.rank() != _qubits)
+	throw std::invalid_argument("State size does not match number of qubits of Pauli string");
+    
+    // Tr(p * P) = sum over j of p(j, j^x) * (-1)^|j&z|
+    const MatrixXcd& density = state.densityMatrix();
+    std::complex< double > res = 0;
+    for (uint64_t j = 0; j < density.rows(); ++j)
+	res += parity(j & _z) * density(j, j ^ _x);
+    return res * _factor();
+}
+
+bool PauliString::commutesWith(const PauliString& other) const
+{
+    return parity((_x & other._z) ^ (_z & other._x)) > 0;
+}
+
+bool PauliString::qubitWiseCommutesWith(const PauliString& other) const
+{
+    uint64_t both = (_x | _z) & (other._x | other._z);
+    return (((_x ^ other._x) | (_z ^ other._z)) & both) == 0;
+}
+
+MatrixXcd PauliString::matrix() const
+{
+    int size = 1 << _qubits;
+    MatrixXcd res = MatrixXcd::Zero(size, size);
+    for (int j = 0; j < size; ++j)
+	res(j ^ _x, j) = parity(j & _z) * _factor();
+    return res;
+}
+
+#endif
+
+#ifndef Getters
+
+std::string PauliString::toString() const
+{
+    std::string res(_qubits, 'I');
+    for (int q = 0; q < _qubits; ++q) {
+	uint64_t bit = (uint64_t) 1 << (_qubits - 1 - q);
+	if ((_x & bit) && (_z & bit)) res[q] = 'Y';
+	else if (_x & bit) res[q] = 'X';
+	else if (_z & bit) res[q] = 'Z';
+    }
+    return res;
+}
+
+int PauliString::qubits() const
+{
+    return _qubits;
+}
+
+uint64_t PauliString::xMask() const
+{
+    return _x;
+}
+
+uint64_t PauliString::zMask() const
+{
+    return _z;
+}
+
+int PauliString::phase() const
+{
+    return _phase;
+}
+
+std::complex< double > PauliString::coefficient() const
+{
+    return _coefficient;
+}
+
+#endif
+
+#ifndef Sum
+
+PauliSum::PauliSum()
+{
+    
+}
+
+PauliSum::PauliSum(const std::vector< PauliString >& terms)
+{
+    for (int i = 0; i < terms.size(); ++i)
+	addTerm(terms[i]);
+}
+
+void PauliSum::addTerm(const PauliString& term)
+{
+    if (!_terms.empty() && _terms[0].qubits() != term.qubits())
+	throw std::invalid_argument("All terms must act on the same number of qubits");
+    _terms.push_back(term);
+}
+
+std::complex< double > PauliSum::expectation(const VectorXcd& vec) const
+{
+    std::complex< double > res = 0;
+    for (int i = 0; i < _terms.size(); ++i)
+	res += _terms[i].expectation(vec);
+    return res;
+}
+
+std::complex< double > PauliSum::expectation(const QuantumState& state) const
+{
+    std::complex< double > res = 0;
+    for (int i = 0; i < _terms.size(); ++i)
+	res += _terms[i].expectation(state);
+    return res;
+}
+
+MatrixXcd PauliSum::matrix() const
+{
+    if (_terms.empty())
+	throw std::runtime_error("Sum has no terms");
+    MatrixXcd res = _terms[0].matrix();
+    for (int i = 1; i < _terms.size(); ++i)
+	res += _terms[i].matrix();
+    return res;
+}
+
+std::vector< std::vector< int > > PauliSum::qubitWiseCommutingGroups() const
+{
+    std::vector< std::vector< int > > groups;
+    for (int i = 0; i < _terms.size(); ++i) {
+	bool placed = false;
+	for (int g = 0; g < groups.size() && !placed; ++g) {
+	    bool fits = true;
+	    for (int j = 0; j < groups[g].size() && fits; ++j)
+		fits = _terms[i].qubitWiseCommutesWith(_terms[groups[g][j]]);
+	    if (fits) {
+		groups[g].push_back(i);
+		placed = true;
+	    }
+	}
+	if (!placed)
+	    groups.push_back(std::vector< int >(1, i));
+    }
+    return groups;
+}
+
+MatrixXcd PauliSum::_groupRotation(const std::vector< int >& group, int qubit) const
+{
+    // rotation U turns Pauli of the group on this qubit into Z: H * X * H = Z, (H * S^+) * Y * (S * H) = Z
+    uint64_t bit = (uint64_t) 1 << (qubits() - 1 - qubit);
+    for (int i = 0; i < group.size(); ++i) {
+	bool x = _terms[group[i]].xMask() & bit, z = _terms[group[i]].zMask() & bit;
+	if (x && z)
+	    return HadamardGate().transformMatrix() * PhaseShiftGate(-M_PI / 2).transformMatrix();
+	if (x)
+	    return HadamardGate().transformMatrix();
+    }
+    return MatrixXcd(); // Z or identity, nothing to rotate
+}
+
+void PauliSum::_estimateGroup(const VectorXd& distribution, const std::vector< int >& group, int shots, PauliEstimates& res) const
+{
+    // after rotation each term is product of Z on its support, so <P> = sum of p_j * (-1)^|j & support|
+    std::vector< uint64_t > supports(group.size());
+    for (int t = 0; t < group.size(); ++t)
+	supports[t] = _terms[group[t]].xMask() | _terms[group[t]].zMask();
+    
+    std::vector< double > acc(group.size(), 0);
+    for (uint64_t j = 0; j < distribution.size(); ++j) {
+	double p = distribution[j];
+	if (p == 0) continue;
+	for (int t = 0; t < group.size(); ++t)
+	    acc[t] += parity(j & supports[t]) * p;
+    }
+    
+    for (int t = 0; t < group.size(); ++t) {
+	std::complex< double > c = _terms[group[t]].coefficient();
+	res.values[group[t]] = c * acc[t];
+	res.variances[group[t]] = std::norm(c) * (1 - acc[t] * acc[t]) / (shots > 0 ? shots : 1);
+    }
+}
+
+PauliEstimates PauliSum::estimateByGroups(const VectorXcd& vec, int shots) const
+{
+    PauliEstimates res;
+    res.groups = qubitWiseCommutingGroups();
+    res.values.resize(_terms.size());
+    res.variances.resize(_terms.size());
+    if (_terms.empty()) return res;
+    if (_terms[0].qubits() >= 31 || vec.size() != (1 << qubits()))
+	throw std::invalid_argument("State size does not match number of qubits of Pauli sum");
+    
+    std::vector< uint > dims(qubits(), 2);
+    for (int g = 0; g < res.groups.size(); ++g) {
+	MatrixXcd rotated = vec;
+	for (int q = 0; q < qubits(); ++q) {
+	    MatrixXcd rotation = _groupRotation(res.groups[g], q);
+	    if (rotation.size() != 0)
+		KroneckerTensor::applyToSubsystem(rotation, q, dims, rotated);
+	}
+	_estimateGroup(rotated.col(0).cwiseAbs2(), res.groups[g], shots, res);
+    }
+    return res;
+}
+
+PauliEstimates PauliSum::estimateByGroups(const QuantumState& state, int shots) const
+{
+    PauliEstimates res;
+    res.groups = qubitWiseCommutingGroups();
+    res.values.resize(_terms.size());
+    res.variances.resize(_terms.size());
+    if (_terms.empty()) return res;
+    HilbertSpace space = state.space();
+    if (space.rank() != qubits())
+	throw std::invalid_argument("State size does not match number of qubits of Pauli sum");
+    for (int i = 0; i < space.rank(); ++i)
+	if (space.dimension(i) != 2)
+	    throw std::invalid_argument("Pauli strings can be measured only on qubits");
+    
+    std::vector< uint > dims = space.dimensions();
+    for (int g = 0; g < res.groups.size(); ++g) {
+	// U * p * U^+ = U * (U * p)^+ since p is Hermit
+	MatrixXcd rotated = state.densityMatrix();
+	bool changed = false;
+	for (int q = 0; q < qubits(); ++q) {
+	    MatrixXcd rotation = _groupRotation(res.groups[g], q);
+	    if (rotation.size() != 0) {
+		KroneckerTensor::applyToSubsystem(rotation, q, dims, rotated);
+		changed = true;
+	    }
+	}
+	if (changed) {
+	    rotated.adjointInPlace();
+	    for (int q = 0; q < qubits(); ++q) {
+		MatrixXcd rotation = _groupRotation(res.groups[g], q);
+		if (rotation.size() != 0)
+		    KroneckerTensor::applyToSubsystem(rotation, q, dims, rotated);
+	    }
+	}
+	_estimateGroup(rotated.diagonal().real(), res.groups[g], shots, res);
+    }
+    return res;
+}
+
+std::vector< PauliString > PauliSum::terms() const
+{
+    return _terms;
+}
+
+int PauliSum::qubits() const
+{
+    return _terms.empty() ? 0 : _terms[0].qubits();
+}
+
+#endif
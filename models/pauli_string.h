@@ -0,0 +1,168 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef PAULI_STRING_H
+#define PAULI_STRING_H
+
+#include "../Eigen/Core"
+#include "quantum_state.h"
+#include <stdint.h>
+#include <complex>
+#include <string>
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * Tensor product of Pauli operators on qubits, e.g. X x I x Z x Y, multiplied by coefficient.
+ * Stored as two bitmasks: operator is coefficient * i^phase * X^xMask * Z^zMask, where bit b of mask is the qubit
+ * with weight 2^b in basis index (so qubit 0 of space is the highest bit). Y on a qubit sets both bits and adds 1 to phase.
+ * 
+ * Expectation values are computed straight from amplitudes: P|j> = i^phase * (-1)^popcount(j & zMask) |j ^ xMask>,
+ * so no matrix is constructed and one term costs O(2^n)
+ */
+class PauliString
+{
+public:
+    /**
+     * Construct Pauli string from text
+     * @param paulis One of 'I', 'X', 'Y', 'Z' per qubit, the first char is subsystem 0
+     * @param coefficient Coefficient of the term
+     */
+    PauliString(const std::string& paulis, std::complex< double > coefficient = 1);
+    
+    /**
+     * Construct Pauli string from masks. Qubits having both bits set hold Y
+     * @param xMask Qubits with X or Y
+     * @param zMask Qubits with Z or Y
+     * @param qubits Number of qubits, up to 64
+     * @param coefficient Coefficient of the term
+     */
+    PauliString(uint64_t xMask, uint64_t zMask, int qubits, std::complex< double > coefficient = 1);
+    
+    /**
+     * Returns <psi|P|psi>. Vector should be normalized
+     */
+    std::complex< double > expectation(const VectorXcd& vec) const;
+    
+    /**
+     * Returns Tr(p * P)
+     */
+    std::complex< double > expectation(const QuantumState& state) const;
+    
+    /**
+     * Returns true if operators commute, i.e. they anticommute on even number of qubits
+     */
+    bool commutesWith(const PauliString& other) const;
+    
+    /**
+     * Returns true if on every qubit operators are the same or one of them is identity.
+     * Such strings can be measured together after one basis rotation
+     */
+    bool qubitWiseCommutesWith(const PauliString& other) const;
+    
+    /**
+     * Returns dense matrix of the operator. Use it only for small number of qubits
+     */
+    MatrixXcd matrix() const;
+    
+    std::string toString() const;
+    int qubits() const;
+    uint64_t xMask() const;
+    uint64_t zMask() const;
+    int phase() const;
+    std::complex< double > coefficient() const;
+    
+private:
+    uint64_t _x, _z;
+    int _phase; // power of i
+    int _qubits;
+    std::complex< double > _coefficient;
+    
+    std::complex< double > _factor() const;
+    void _checkSize(int size) const;
+};
+
+/**
+ * Values of Pauli sum terms estimated by qubit-wise commuting groups
+ */
+struct PauliEstimates
+{
+    std::vector< std::complex< double > > values; // expectation of each term, coefficient included
+    std::vector< double > variances; // variance of the estimate of each term from given number of shots
+    std::vector< std::vector< int > > groups; // term indexes of each group
+};
+
+/**
+ * Observable given as sum of Pauli strings with coefficients, e.g. Hamiltonian
+ */
+class PauliSum
+{
+public:
+    PauliSum();
+    PauliSum(const std::vector< PauliString >& terms);
+    
+    /**
+     * Add one more term. All terms must act on the same number of qubits
+     */
+    void addTerm(const PauliString& term);
+    
+    /**
+     * Returns sum of expectations of all terms
+     */
+    std::complex< double > expectation(const VectorXcd& vec) const;
+    std::complex< double > expectation(const QuantumState& state) const;
+    
+    /**
+     * Returns dense matrix of the observable. Use it only for small number of qubits
+     */
+    MatrixXcd matrix() const;
+    
+    /**
+     * Split terms into groups where all terms qubit-wise commute (greedy, first fit)
+     * @return Term indexes of each group
+     */
+    std::vector< std::vector< int > > qubitWiseCommutingGroups() const;
+    
+    /**
+     * Evaluate all terms group by group: state is rotated once per group (H for X, H * S^+ for Y) and every term of the
+     * group is read from the same diagonal distribution. For sums of 10^3 terms it needs far less passes than expectation()
+     * @param shots Number of shots the estimate is assumed to be made from; variance of term c*P is |c|^2 * (1 - <P>^2) / shots
+     */
+    PauliEstimates estimateByGroups(const VectorXcd& vec, int shots = 1) const;
+    PauliEstimates estimateByGroups(const QuantumState& state, int shots = 1) const;
+    
+    std::vector< PauliString > terms() const;
+    int qubits() const;
+    
+private:
+    std::vector< PauliString > _terms;
+    
+    MatrixXcd _groupRotation(const std::vector< int >& group, int qubit) const;
+    void _estimateGroup(const VectorXd& distribution, const std::vector< int >& group, int shots, PauliEstimates& res) const;
+};
+
+#endif // PAULI_STRING_H
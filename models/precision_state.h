@@ -0,0 +1,371 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef PRECISION_STATE_H
+#define PRECISION_STATE_H
+
+#include "../Eigen/Core"
+#include "hilbert_space.h"
+#include "quantum_state.h"
+#include "circuit.h"
+#include "kronecker_tensor.h"
+#include "random_generator.h"
+#include <algorithm>
+#include <complex>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * State vector with amplitudes stored as std::complex< Scalar >. With Scalar = float it takes half of memory and
+ * bandwidth of the double state (one qubit more per node, the class is keyed on subsystem dimensions and its size may
+ * exceed int), while reductions (norm, probabilities, expectations,
+ * measurement) are accumulated in double, so only storage rounding is lost. Rounding is tracked: errorBound() is the
+ * a priori bound on distance to exact state, normDrift() is the observed deviation of norm from 1
+ */
+template < typename Scalar >
+class PrecisionState
+{
+public:
+    typedef std::complex< Scalar > Complex;
+    typedef Matrix< Complex, Dynamic, 1 > Vector;
+    typedef Matrix< Complex, Dynamic, Dynamic > Operator;
+    
+    /**
+     * State |0...0> of subsystems of given dimensions
+     */
+    PrecisionState(const std::vector< uint >& dimensions);
+    PrecisionState(const VectorXcd& vec, const std::vector< uint >& dimensions);
+    
+    /**
+     * Apply operator to listed subsystems, see KroneckerTensor::applyToSubsystems(). Operator is rounded to Scalar
+     */
+    void apply(const MatrixXcd& op, const std::vector< int >& subsystems);
+    void apply(const Circuit& circuit);
+    
+    /**
+     * Measure subsystem in computational basis and collapse the state
+     * @return Index of outcome
+     */
+    int measure(int subsystem, RandomGenerator& generator);
+    
+    /**
+     * Rescale to unit norm, normDrift() drops to storage rounding, errorBound() is kept
+     */
+    void normalize();
+    
+    double norm() const;
+    VectorXd probabilities() const;
+    
+    /**
+     * Expectation <psi| O |psi> of local Hermit operator, operator is applied in double
+     */
+    double expectation(const MatrixXcd& op, const std::vector< int >& subsystems) const;
+    
+    /**
+     * Bound on ||psi - psi_exact|| from rounding of amplitudes and gates since construction (first order in epsilon)
+     */
+    double errorBound() const;
+    
+    /**
+     * |1 - <psi|psi>|, cheap a posteriori estimate of accumulated error
+     */
+    double normDrift() const;
+    
+    const Vector& amplitudes() const;
+    VectorXcd toVector() const;
+    QuantumState toQuantumState() const;
+    
+    /**
+     * Space of the state; throws for states whose total dimension does not fit in int, see dimensions()
+     */
+    HilbertSpace space() const;
+    const std::vector< uint >& dimensions() const;
+    
+private:
+    Vector _amplitudes;
+    std::vector< uint > _dimensions;
+    double _errorBound; // relative to the norm, so unitary gates do not need it
+    
+    void _init(const std::vector< uint >& dimensions);
+    std::vector< long long > _strides() const;
+    std::vector< long long > _offsets(const std::vector< int >& subsystems, int& localDim) const;
+    bool _nextBase(const std::vector< int >& subsystems, const std::vector< long long >& strides, std::vector< int >& digits, long long& base) const;
+};
+
+#ifndef Constructors
+
+template < typename Scalar >
+PrecisionState< Scalar >::PrecisionState(const std::vector< uint >& dimensions)
+{
+    _init(dimensions);
+    _amplitudes.setZero();
+    _amplitudes[0] = 1;
+    _errorBound = 0;
+}
+
+template < typename Scalar >
+PrecisionState< Scalar >::PrecisionState(const VectorXcd& vec, const std::vector< uint >& dimensions)
+{
+    _init(dimensions);
+    if (vec.size() != _amplitudes.size())
+	throw std::invalid_argument("Space total dimension shold be the same as vector size");
+    _amplitudes = vec.cast< Complex >();
+    // relative rounding of each component is at most epsilon / 2
+    _errorBound = std::numeric_limits< Scalar >::epsilon() / 2;
+}
+
+template < typename Scalar >
+void PrecisionState< Scalar >::_init(const std::vector< uint >& dimensions)
+{
+    long long size = 1;
+    for (int i = 0; i < dimensions.size(); ++i) {
+	if (dimensions[i] == 0)
+	    throw std::invalid_argument("Dimension cannot be zero");
+	if (size > std::numeric_limits< long long >::max() / sizeof(Complex) / dimensions[i])
+	    throw std::invalid_argument("State vector is too large");
+	size *= dimensions[i];
+    }
+    _dimensions = dimensions;
+    _amplitudes.resize(size);
+}
+
+#endif
+
+#ifndef Kernel
+
+template < typename Scalar >
+std::vector< long long > PrecisionState< Scalar >::_strides() const
+{
+    std::vector< long long > strides(_dimensions.size(), 1);
+    for (int i = (int) _dimensions.size() - 2; i >= 0; --i)
+	strides[i] = strides[i + 1] * _dimensions[i + 1];
+    return strides;
+}
+
+template < typename Scalar >
+std::vector< long long > PrecisionState< Scalar >::_offsets(const std::vector< int >& subsystems, int& localDim) const
+{
+    const std::vector< uint >& dims = _dimensions;
+    std::vector< long long > strides = _strides();
+    localDim = KroneckerTensor::localDimension(subsystems, dims);
+    std::vector< long long > offsets(localDim, 0);
+    for (int a = 0; a < localDim; ++a) {
+	int rest = a;
+	for (int i = (int) subsystems.size() - 1; i >= 0; --i) {
+	    offsets[a] += (rest % dims[subsystems[i]]) * strides[subsystems[i]];
+	    rest /= dims[subsystems[i]];
+	}
+    }
+    return offsets;
+}
+
+template < typename Scalar >
+bool PrecisionState< Scalar >::_nextBase(const std::vector< int >& subsystems, const std::vector< long long >& strides, std::vector< int >& digits, long long& base) const
+{
+    // increment digits of subsystems not in list, lowest first
+    for (int i = (int) digits.size() - 1; i >= 0; --i) {
+	if (std::find(subsystems.begin(), subsystems.end(), i) != subsystems.end()) continue;
+	if (++digits[i] < _dimensions[i]) {
+	    base += strides[i];
+	    return true;
+	}
+	base -= (digits[i] - 1) * strides[i];
+	digits[i] = 0;
+    }
+    return false;
+}
+
+#endif
+
+#ifndef Performing
+
+template < typename Scalar >
+void PrecisionState< Scalar >::apply(const MatrixXcd& op, const std::vector< int >& subsystems)
+{
+    int localDim;
+    std::vector< long long > offsets = _offsets(subsystems, localDim);
+    if (op.rows() != localDim || op.cols() != localDim)
+	throw std::invalid_argument("Operator size does not match subsystems dimensions");
+    Operator rounded = op.cast< Complex >();
+    
+    Vector in(localDim), out(localDim);
+    std::vector< long long > strides = _strides();
+    std::vector< int > digits(_dimensions.size(), 0);
+    long long base = 0;
+    do {
+	for (int a = 0; a < localDim; ++a)
+	    in[a] = _amplitudes[base + offsets[a]];
+	out.noalias() = rounded * in;
+	for (int a = 0; a < localDim; ++a)
+	    _amplitudes[base + offsets[a]] = out[a];
+    } while (_nextBase(subsystems, strides, digits, base));
+    
+    // rounding of gate entries, of localDim-term sums and of stored result; gate norm is 1 for unitaries
+    const double eps = std::numeric_limits< Scalar >::epsilon();
+    _errorBound += (localDim + 2) * eps;
+}
+
+template < typename Scalar >
+void PrecisionState< Scalar >::apply(const Circuit& circuit)
+{
+    if (circuit.dimensions() != _dimensions)
+	throw std::invalid_argument("Circuit space does not match state space");
+    for (int i = 0; i < circuit.gatesCount(); ++i)
+	apply(circuit.gate(i).matrix, circuit.gate(i).subsystems);
+}
+
+template < typename Scalar >
+int PrecisionState< Scalar >::measure(int subsystem, RandomGenerator& generator)
+{
+    if (subsystem < 0 || subsystem >= _dimensions.size())
+	throw std::invalid_argument("Index of subsystem is outside of space bounds");
+    long long stride = _strides()[subsystem];
+    int dim = _dimensions[subsystem];
+    std::vector< double > weights(dim, 0);
+    double total = 0;
+    for (long long i = 0; i < _amplitudes.size(); ++i) {
+	double p = std::norm(std::complex< double >(_amplitudes[i]));
+	weights[(i / stride) % dim] += p;
+	total += p;
+    }
+    
+    double r = generator.uniform() * total;
+    int outcome = 0;
+    while (outcome < dim - 1 && r >= weights[outcome])
+	r -= weights[outcome++];
+    Scalar scale = Scalar(1 / sqrt(weights[outcome]));
+    for (long long i = 0; i < _amplitudes.size(); ++i)
+	_amplitudes[i] = (i / stride) % dim == outcome ? _amplitudes[i] * scale : Complex(0);
+    // projection keeps the absolute error, rescaling to unit norm divides it by sqrt of outcome probability
+    _errorBound = _errorBound / sqrt(weights[outcome] / total) + std::numeric_limits< Scalar >::epsilon();
+    return outcome;
+}
+
+template < typename Scalar >
+void PrecisionState< Scalar >::normalize()
+{
+    _amplitudes *= Scalar(1 / norm());
+}
+
+template < typename Scalar >
+double PrecisionState< Scalar >::expectation(const MatrixXcd& op, const std::vector< int >& subsystems) const
+{
+    int localDim;
+    std::vector< long long > offsets = _offsets(subsystems, localDim);
+    if (op.rows() != localDim || op.cols() != localDim)
+	throw std::invalid_argument("Operator size does not match subsystems dimensions");
+    
+    VectorXcd in(localDim);
+    std::vector< long long > strides = _strides();
+    std::vector< int > digits(_dimensions.size(), 0);
+    long long base = 0;
+    std::complex< double > res = 0;
+    do {
+	for (int a = 0; a < localDim; ++a)
+	    in[a] = std::complex< double >(_amplitudes[base + offsets[a]]);
+	res += in.dot(op * in);
+    } while (_nextBase(subsystems, strides, digits, base));
+    return res.real();
+}
+
+#endif
+
+#ifndef Getters
+
+template < typename Scalar >
+double PrecisionState< Scalar >::norm() const
+{
+    double res = 0;
+    for (long long i = 0; i < _amplitudes.size(); ++i)
+	res += std::norm(std::complex< double >(_amplitudes[i]));
+    return sqrt(res);
+}
+
+template < typename Scalar >
+VectorXd PrecisionState< Scalar >::probabilities() const
+{
+    VectorXd res(_amplitudes.size());
+    for (long long i = 0; i < _amplitudes.size(); ++i)
+	res[i] = std::norm(std::complex< double >(_amplitudes[i]));
+    return res;
+}
+
+template < typename Scalar >
+double PrecisionState< Scalar >::errorBound() const
+{
+    return _errorBound * norm();
+}
+
+template < typename Scalar >
+double PrecisionState< Scalar >::normDrift() const
+{
+    double n = norm();
+    return std::abs(1 - n * n);
+}
+
+template < typename Scalar >
+const typename PrecisionState< Scalar >::Vector& PrecisionState< Scalar >::amplitudes() const
+{
+    return _amplitudes;
+}
+
+template < typename Scalar >
+VectorXcd PrecisionState< Scalar >::toVector() const
+{
+    return _amplitudes.template cast< std::complex< double > >();
+}
+
+template < typename Scalar >
+QuantumState PrecisionState< Scalar >::toQuantumState() const
+{
+    VectorXcd vec = toVector();
+    vec /= vec.norm();
+    return QuantumState(vec, space());
+}
+
+template < typename Scalar >
+HilbertSpace PrecisionState< Scalar >::space() const
+{
+    return HilbertSpace(_dimensions);
+}
+
+template < typename Scalar >
+const std::vector< uint >& PrecisionState< Scalar >::dimensions() const
+{
+    return _dimensions;
+}
+
+#endif
+
+/**
+ * Mixed precision mode: single precision storage, double accumulation
+ */
+typedef PrecisionState< float > MixedPrecisionState;
+
+#endif // PRECISION_STATE_H
@@ -0,0 +1,296 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "product_state.h"
+#include "kronecker_tensor.h"
+#include "schmidt_decomposition.h"
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef Constructors
+
+ProductState::ProductState(const QuantumState& state)
+{
+    tensorWith(state);
+}
+
+ProductState::ProductState(const std::vector< QuantumState >& factors)
+{
+    for (int i = 0; i < factors.size(); ++i)
+	tensorWith(factors[i]);
+}
+
+void ProductState::tensorWith(const QuantumState& state)
+{
+    std::vector< int > subsystems;
+    for (int i = 0; i < state.space().rank(); ++i)
+	subsystems.push_back(_factorOf.size() + i);
+    _factors.push_back(state);
+    _subsystems.push_back(subsystems);
+    _reindex();
+}
+
+#endif
+
+void ProductState::_reindex()
+{
+    int total = 0;
+    for (int f = 0; f < _subsystems.size(); ++f)
+	total += _subsystems[f].size();
+    _factorOf.assign(total, -1);
+    _positionIn.assign(total, -1);
+    for (int f = 0; f < _subsystems.size(); ++f)
+	for (int i = 0; i < _subsystems[f].size(); ++i) {
+	    _factorOf[_subsystems[f][i]] = f;
+	    _positionIn[_subsystems[f][i]] = i;
+	}
+}
+
+void ProductState::_checkSubsystem(int subsystem) const
+{
+    if (subsystem < 0 || subsystem >= _factorOf.size())
+	throw std::invalid_argument("This state have not such subsystem");
+}
+
+int ProductState::_merge(std::vector< int > factors)
+{
+    std::sort(factors.begin(), factors.end());
+    factors.erase(std::unique(factors.begin(), factors.end()), factors.end());
+    if (factors.size() == 1)
+	return factors[0];
+    
+    QuantumState merged = _factors[factors[0]];
+    std::vector< int > subsystems = _subsystems[factors[0]];
+    for (int i = 1; i < factors.size(); ++i) {
+	merged = QuantumState::tensor(merged, _factors[factors[i]]);
+	subsystems.insert(subsystems.end(), _subsystems[factors[i]].begin(), _subsystems[factors[i]].end());
+    }
+    
+    for (int i = factors.size() - 1; i > 0; --i) {
+	_factors.erase(_factors.begin() + factors[i]);
+	_subsystems.erase(_subsystems.begin() + factors[i]);
+    }
+    _factors[factors[0]] = merged;
+    _subsystems[factors[0]] = subsystems;
+    _reindex();
+    return factors[0];
+}
+
+void ProductState::_applyToFactor(const MatrixXcd& matr, int factor, const std::vector< int >& positions)
+{
+    // U * p * U^+ = U * (U * p)^+ since p is Hermit
+    std::vector< uint > dims = _factors[factor].space().dimensions();
+    MatrixXcd density = _factors[factor].densityMatrix();
+    KroneckerTensor::applyToSubsystems(matr, positions, dims, density);
+    density.adjointInPlace();
+    KroneckerTensor::applyToSubsystems(matr, positions, dims, density);
+    _factors[factor].setMatrix(density);
+}
+
+void ProductState::_detach(int subsystem, const QuantumState& state, const QuantumState& rest)
+{
+    int factor = _factorOf[subsystem];
+    _factors[factor] = rest;
+    _subsystems[factor].erase(_subsystems[factor].begin() + _positionIn[subsystem]);
+    _factors.insert(_factors.begin() + factor, state);
+    _subsystems.insert(_subsystems.begin() + factor, std::vector< int >(1, subsystem));
+    _reindex();
+}
+
+void ProductState::_splitCluster(const std::vector< int >& subsystems)
+{
+    // one subsystem at a time: splitting one off may make another cut separable, so repeat until nothing changes
+    bool changed = true;
+    while (changed) {
+	changed = false;
+	for (int i = 0; i < subsystems.size(); ++i)
+	    if (_subsystems[_factorOf[subsystems[i]]].size() > 1 && split(subsystems[i]))
+		changed = true;
+    }
+}
+
+VectorXcd ProductState::_pureVector(const MatrixXcd& density)
+{
+    // p = |psi><psi|, so column j is psi * conj(psi_j); take the column with the largest diagonal element
+    int col;
+    density.diagonal().real().maxCoeff(&col);
+    return density.col(col) / sqrt(density(col, col).real());
+}
+
+#ifndef Performing
+
+void ProductState::apply(const UnitaryTransformation& gate, const std::vector< int >& subsystems)
+{
+    std::vector< int > factors;
+    std::vector< uint > dims;
+    for (int i = 0; i < subsystems.size(); ++i) {
+	_checkSubsystem(subsystems[i]);
+	factors.push_back(_factorOf[subsystems[i]]);
+	dims.push_back(_factors[factors.back()].space().dimension(_positionIn[subsystems[i]]));
+    }
+    // checked before merging, so a rejected gate leaves factors untouched; flat gate space must still have the right size
+    if (gate.space().totalDimension() != HilbertSpace(dims).totalDimension() || (gate.space().rank() > 1 && gate.space() != HilbertSpace(dims)))
+	throw std::invalid_argument("Space of gate must match dimensions of subsystems");
+    
+    int factor = _merge(factors);
+    std::vector< int > positions;
+    for (int i = 0; i < subsystems.size(); ++i)
+	positions.push_back(_positionIn[subsystems[i]]);
+    _applyToFactor(gate.transformMatrix(), factor, positions);
+}
+
+void ProductState::apply(const UnitaryTransformation& gate, int subsystem)
+{
+    apply(gate, std::vector< int >(1, subsystem));
+}
+
+int ProductState::measure(Measurement& measurement, int subsystem, RandomGenerator& generator)
+{
+    _checkSubsystem(subsystem);
+    int factor = _factorOf[subsystem];
+    QuantumState& state = _factors[factor];
+    std::vector< int > cluster = _subsystems[factor];
+    int outcome = measurement.performOutcome(&state, generator, state.space().rank() == 1 ? -1 : _positionIn[subsystem]);
+    _splitCluster(cluster);
+    return outcome;
+}
+
+void ProductState::reset(int subsystem)
+{
+    _checkSubsystem(subsystem);
+    int factor = _factorOf[subsystem];
+    uint dim = _factors[factor].space().dimension(_positionIn[subsystem]);
+    VectorXcd zero = VectorXcd::Zero(dim);
+    zero[0] = 1;
+    QuantumState ground(zero, HilbertSpace(dim));
+    
+    if (_subsystems[factor].size() == 1) {
+	_factors[factor] = ground;
+	return;
+    }
+    std::vector< int > rest = _subsystems[factor];
+    rest.erase(rest.begin() + _positionIn[subsystem]);
+    _detach(subsystem, ground, _factors[factor].partialTrace(_positionIn[subsystem]));
+    _splitCluster(rest);
+}
+
+bool ProductState::split(int subsystem, double tolerance)
+{
+    _checkSubsystem(subsystem);
+    int factor = _factorOf[subsystem];
+    if (_subsystems[factor].size() == 1)
+	return true;
+    const QuantumState& state = _factors[factor];
+    if (!state.isPure())
+	return false;
+    
+    int position = _positionIn[subsystem];
+    SchmidtDecomposition schmidt(_pureVector(state.densityMatrix()), state.space(), std::vector< int >(1, position), tolerance);
+    if (schmidt.rank() != 1)
+	return false;
+    
+    std::vector< uint > dims = state.space().dimensions();
+    dims.erase(dims.begin() + position);
+    QuantumState single(schmidt.basisA().col(0), HilbertSpace(state.space().dimension(position)));
+    QuantumState rest(schmidt.basisB().col(0), HilbertSpace(dims));
+    _detach(subsystem, single, rest);
+    return true;
+}
+
+ProductState ProductState::partialTrace(int index) const
+{
+    _checkSubsystem(index);
+    if (_factorOf.size() == 1)
+	throw std::invalid_argument("Cannot trace out the last subsystem");
+    ProductState res = *this;
+    int factor = _factorOf[index];
+    if (_subsystems[factor].size() == 1) {
+	res._factors.erase(res._factors.begin() + factor);
+	res._subsystems.erase(res._subsystems.begin() + factor);
+    }
+    else {
+	res._factors[factor] = _factors[factor].partialTrace(_positionIn[index]);
+	res._subsystems[factor].erase(res._subsystems[factor].begin() + _positionIn[index]);
+    }
+    for (int f = 0; f < res._subsystems.size(); ++f)
+	for (int i = 0; i < res._subsystems[f].size(); ++i)
+	    if (res._subsystems[f][i] > index)
+		--res._subsystems[f][i];
+    res._reindex();
+    return res;
+}
+
+QuantumState ProductState::toQuantumState() const
+{
+    QuantumState product = _factors[0];
+    std::vector< int > order = _subsystems[0];
+    for (int f = 1; f < _factors.size(); ++f) {
+	product = QuantumState::tensor(product, _factors[f]);
+	order.insert(order.end(), _subsystems[f].begin(), _subsystems[f].end());
+    }
+    
+    // subsystem at position i of the product is the global one order[i], bring it to its place
+    std::vector< int > perm(order.size());
+    for (int i = 0; i < order.size(); ++i)
+	perm[order[i]] = i;
+    product.permuteSubsystems(perm);
+    return product;
+}
+
+#endif
+
+#ifndef Getters
+
+int ProductState::factorsCount() const
+{
+    return _factors.size();
+}
+
+QuantumState ProductState::factor(int index) const
+{
+    return _factors.at(index);
+}
+
+std::vector< int > ProductState::factorSubsystems(int index) const
+{
+    return _subsystems.at(index);
+}
+
+int ProductState::factorOf(int subsystem) const
+{
+    _checkSubsystem(subsystem);
+    return _factorOf[subsystem];
+}
+
+HilbertSpace ProductState::space() const
+{
+    std::vector< uint > dims(_factorOf.size());
+    for (int s = 0; s < dims.size(); ++s)
+	dims[s] = _factors[_factorOf[s]].space().dimension(_positionIn[s]);
+    return HilbertSpace(dims);
+}
+
+#endif
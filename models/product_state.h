@@ -0,0 +1,133 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef PRODUCT_STATE_H
+#define PRODUCT_STATE_H
+
+#include "quantum_state.h"
+#include "unitary_transformation.h"
+#include "measurement.h"
+#include "random_generator.h"
+#include <vector>
+
+/**
+ * Quantum state kept as tensor product of independent factors (clusters of entangled subsystems). Factors are merged
+ * when a gate acts on subsystems from different factors and split again when measurement or reset leaves a subsystem
+ * not entangled with the rest of its factor; gates, measurements and partial traces inside one factor touch only it.
+ * Subsystems are numbered globally in order of construction, whatever factor holds them
+ */
+class ProductState
+{
+public:
+    /**
+     * Construct product state with single factor
+     */
+    ProductState(const QuantumState& state);
+    
+    /**
+     * Construct product state of factors. Subsystems of the first factor go first, and so on
+     */
+    ProductState(const std::vector< QuantumState >& factors);
+    
+    /**
+     * Add one more factor. Its subsystems get indexes after the existing ones
+     */
+    void tensorWith(const QuantumState& state);
+    
+    /**
+     * Apply gate to listed subsystems. Factors holding them are merged if there are several
+     * @param gate Transform whose space matches dimensions of listed subsystems
+     * @param subsystems Global indexes of subsystems, in order of gate space
+     */
+    void apply(const UnitaryTransformation& gate, const std::vector< int >& subsystems);
+    void apply(const UnitaryTransformation& gate, int subsystem);
+    
+    /**
+     * Perform measurement on one subsystem, only factor holding it is changed. Afterwards every subsystem of that
+     * factor is split off if possible, see split()
+     * @return Index of outcome, see Measurement::performOutcome()
+     */
+    int measure(Measurement& measurement, int subsystem, RandomGenerator& generator);
+    
+    /**
+     * Put subsystem into basis state |0> as its own factor. Rest of its factor is replaced by reduced state, which is
+     * split further if it is pure and factorises
+     */
+    void reset(int subsystem);
+    
+    /**
+     * Try to move subsystem to its own factor. Done only if the factor is pure and its Schmidt rank for the cut
+     * between the subsystem and the rest is one; mixed factors are kept as is
+     * @param tolerance Schmidt coefficients below it are treated as zero
+     * @return Whether the subsystem holds its own factor now
+     */
+    bool split(int subsystem, double tolerance = 1.0e-7);
+    
+    /**
+     * Trace out subsystem. Remaining subsystems with bigger indexes are shifted down by one; the last subsystem cannot
+     * be traced out
+     */
+    ProductState partialTrace(int index) const;
+    
+    /**
+     * Construct full state. Costs as much as the full density matrix, use it wisely
+     */
+    QuantumState toQuantumState() const;
+    
+    int factorsCount() const;
+    QuantumState factor(int index) const;
+    
+    /**
+     * Global indexes of subsystems held by factor, in order of its own space
+     */
+    std::vector< int > factorSubsystems(int index) const;
+    
+    /**
+     * Index of factor that holds subsystem
+     */
+    int factorOf(int subsystem) const;
+    
+    /**
+     * Space of the whole state, throws std::invalid_argument when its total dimension does not fit in int; gates and
+     * measurements only need spaces of factors
+     */
+    HilbertSpace space() const;
+    
+protected:
+    std::vector< QuantumState > _factors;
+    std::vector< std::vector< int > > _subsystems;
+    std::vector< int > _factorOf, _positionIn; // for each global subsystem
+    
+    void _reindex();
+    void _checkSubsystem(int subsystem) const;
+    int _merge(std::vector< int > factors);
+    void _applyToFactor(const MatrixXcd& matr, int factor, const std::vector< int >& positions);
+    void _splitCluster(const std::vector< int >& subsystems);
+    void _detach(int subsystem, const QuantumState& state, const QuantumState& rest);
+    static VectorXcd _pureVector(const MatrixXcd& density);
+};
+
+#endif // PRODUCT_STATE_H
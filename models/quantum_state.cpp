@@ -30,24 +30,43 @@
 
 QuantumState::QuantumState(MatrixXcd matr, const HilbertSpace & space)
 {
+    _spectrumReady = false;
     if (matr.cols() == 1) {// state represented by vector, need to construct matrix	
+	// |psi><psi| of normalized vector is a density matrix, so eigen solver is not needed
 	matr.normalize();
-	_density = matr * matr.transpose();
+	_density = matr * matr.adjoint();
     }
     else {
 	_checkMatrixIsSquare(matr);
 	_density = matr;
+	if (!_checkMatrixIsSelfAdjoined(_density))
+	    throw std::invalid_argument("Matrix should be selfadjoined");
+	_calculateEigenValuesAndVectors();
+	_checkMatrixIsDensityMatrix(_density);
     }
-    
-    _calculateEigenValuesAndVectors(_density);
-    _checkMatrixIsDensityMatrix(_density);
     _checkSpaceDimension(_density, space);
     _space = space;
 }
 
 QuantumState QuantumState::tensor(const QuantumState& first, const QuantumState& second)
 {
-    return QuantumState(KroneckerTensor::product(first._density, second._density), HilbertSpace::tensor(first._space, second._space));
+    // product of two density matrices is a density matrix, so it is not checked again with eigen solver
+    QuantumState res = first;
+    res._density = KroneckerTensor::product(first._density, second._density);
+    res._space = HilbertSpace::tensor(first._space, second._space);
+    res._spectrumReady = false;
+    return res;
+}
+
+void QuantumState::permuteSubsystems(const std::vector< int >& perm)
+{
+    std::vector< uint > dims = _space.dimensions();
+    KroneckerTensor::permuteSubsystems(perm, dims, _density);
+    std::vector< uint > newDims(dims.size());
+    for (int i = 0; i < dims.size(); ++i)
+	newDims[i] = dims[perm[i]];
+    _space = HilbertSpace(newDims);
+    _spectrumReady = false;
 }
 
 QuantumState QuantumState::partialTrace(int index) const
@@ -101,18 +120,76 @@ QuantumState QuantumState::partialTrace(int index) const
     return QuantumState(res, newSpace);
 }
 
+#ifndef Marginals
+
+std::vector< std::vector< double > > QuantumState::marginalProbabilities(const std::vector< std::vector< int > >& subsets) const
+{
+    return _accumulateMarginals(_density.diagonal().real(), _space, subsets);
+}
+
+std::vector< std::vector< double > > QuantumState::marginalProbabilities(const VectorXcd& vec, const HilbertSpace& space, const std::vector< std::vector< int > >& subsets)
+{
+    if (vec.size() != space.totalDimension())
+	throw std::invalid_argument("Space total dimension shold be the same as vector size");
+    return _accumulateMarginals(vec.cwiseAbs2() / vec.squaredNorm(), space, subsets);
+}
+
+std::vector< std::vector< double > > QuantumState::_accumulateMarginals(const VectorXd& diagonal, const HilbertSpace& space, const std::vector< std::vector< int > >& subsets)
+{
+    int rank = space.rank();
+    
+    // binStrides[s][j] is the weight of subsystem subsets[s][j] digit in the bin index of subset s
+    std::vector< std::vector< int > > binStrides(subsets.size());
+    std::vector< std::vector< double > > res(subsets.size());
+    for (int s = 0; s < subsets.size(); ++s) {
+	std::vector< bool > used(rank, false);
+	int bins = 1;
+	binStrides[s].resize(subsets[s].size());
+	for (int j = (int) subsets[s].size() - 1; j >= 0; --j) {
+	    int sub = subsets[s][j];
+	    if (sub < 0 || sub >= rank) throw std::invalid_argument("This state have not such subsystem");
+	    if (used[sub]) throw std::invalid_argument("Subsystem cannot be listed twice in one subset");
+	    used[sub] = true;
+	    binStrides[s][j] = bins;
+	    bins *= space.dimension(sub);
+	}
+	res[s].assign(bins, 0);
+    }
+    
+    // digits of current index are kept as odometer, so nothing is divided inside the loop
+    std::vector< int > digits(rank, 0), dims(rank);
+    for (int i = 0; i < rank; ++i) dims[i] = space.dimension(i);
+    
+    for (int index = 0; index < diagonal.size(); ++index) {
+	double p = diagonal[index];
+	for (int s = 0; s < subsets.size(); ++s) {
+	    int bin = 0;
+	    for (int j = 0; j < subsets[s].size(); ++j)
+		bin += digits[subsets[s][j]] * binStrides[s][j];
+	    res[s][bin] += p;
+	}
+	for (int i = rank - 1; i >= 0; --i) {
+	    if (++digits[i] < dims[i]) break;
+	    digits[i] = 0;
+	}
+    }
+    return res;
+}
+
+#endif
+
 #ifndef Checks
 
-void QuantumState::_calculateEigenValuesAndVectors(MatrixXcd matr) {
-    if (!_checkMatrixIsSelfAdjoined(matr))
-	throw std::invalid_argument("Matrix should be selfadjoined");
+void QuantumState::_calculateEigenValuesAndVectors() const {
+    if (_spectrumReady) return;
     
-    SelfAdjointEigenSolver<MatrixXcd> solver(matr);
+    SelfAdjointEigenSolver<MatrixXcd> solver(_density);
     if (solver.info() != Eigen::Success)
 	throw std::runtime_error("Something is wrong with eigen solver");
     
     _eigenValues = solver.eigenvalues();
     _eigenVectors = solver.eigenvectors();
+    _spectrumReady = true;
 }
 
 void QuantumState::_checkMatrixIsSquare(MatrixXcd matr) {
@@ -130,7 +207,11 @@ void QuantumState::_checkMatrixIsDensityMatrix(MatrixXcd matr) {
 	    if (_eigenValues[i] < 0) // we dont like negative values
 		throw std::invalid_argument("This is not density matrix because it contains negative eigen values: ");
     
-    if (abs(matr.trace() - std::complex< double >(1, 0)) > 1.0e-15)
+    _checkTrace(matr);
+}
+
+void QuantumState::_checkTrace(const MatrixXcd& matr, double tolerance) {
+    if (abs(matr.trace() - std::complex< double >(1, 0)) > tolerance)
 	throw std::invalid_argument("Matrix should have trace equal to 1");
 }
 
@@ -142,16 +223,22 @@ void QuantumState::_checkSpaceDimension(MatrixXcd matr, HilbertSpace space) {
 #endif
 
 bool QuantumState::isPure() const {
-    MatrixXcd square = _density * _density;
-    return abs(square.trace() - std::complex< double >(1, 0)) < 1.0e-15;
+    return abs(purity() - 1) < 1.0e-12;
+}
+
+double QuantumState::purity() const {
+    // Tr(p * p) = sum of |p_ij|^2 for Hermit p, no need in the product
+    return _density.squaredNorm();
 }
 
 void QuantumState::setMatrix(MatrixXcd matr) {
     _checkMatrixIsSquare(matr);
     _checkSpaceDimension(matr, _space);
-    _calculateEigenValuesAndVectors(matr);
-    _checkMatrixIsDensityMatrix(matr);
+    if (!_checkMatrixIsSelfAdjoined(matr))
+	throw std::invalid_argument("Matrix should be selfadjoined");
+    _checkTrace(matr, 1.0e-10); // rounding errors of many gates are accumulated
     _density = matr;
+    _spectrumReady = false; // will be computed if somebody asks
 }
 
 #ifndef Getters
@@ -160,15 +247,17 @@ HilbertSpace QuantumState::space() const {
     return _space;
 }
 
-MatrixXcd QuantumState::densityMatrix() const {
+const MatrixXcd& QuantumState::densityMatrix() const {
     return _density;
 }
 
 VectorXd QuantumState::eigenValues() const {
+    _calculateEigenValuesAndVectors();
     return _eigenValues;
 }
 
 MatrixXcd QuantumState::eigenVectors() const {
+    _calculateEigenValuesAndVectors();
     return _eigenVectors;
 }
 
@@ -47,7 +47,7 @@ public:
     /**
      * Returns density matrix of current state
      */
-    MatrixXcd densityMatrix() const;
+    const MatrixXcd& densityMatrix() const;
     
     /**
      * Create new state that will be result of tensor product of 2 other states
@@ -57,7 +57,27 @@ public:
     QuantumState partialTrace(int index) const;
     
     /**
-     * Returns eigen values in vector of *real* numbers. Size of vector equals to the density matrix size
+     * Reorder subsystems: subsystem i of the new state is subsystem perm[i] of the current one. Space is reordered too.
+     * Done as tensor transpose of density matrix, see KroneckerTensor::permuteSubsystems()
+     */
+    void permuteSubsystems(const std::vector< int >& perm);
+    
+    /**
+     * Returns probability distributions of computational basis outcomes of several subsystem subsets at once.
+     * All distributions are accumulated in one pass over the diagonal of density matrix
+     * @param subsets Each subset lists subsystem indexes, the first one is the most significant in the outcome index
+     * @return i-th item is distribution for subsets[i]; its size is product of dimensions of subsystems in the subset
+     */
+    std::vector< std::vector< double > > marginalProbabilities(const std::vector< std::vector< int > >& subsets) const;
+    
+    /**
+     * The same as above for pure state given by its vector, probabilities are |amplitude|^2
+     */
+    static std::vector< std::vector< double > > marginalProbabilities(const VectorXcd& vec, const HilbertSpace& space, const std::vector< std::vector< int > >& subsets);
+    
+    /**
+     * Returns eigen values in vector of *real* numbers. Size of vector equals to the density matrix size.
+     * Spectrum is computed on first request after the state has changed and cached
      */
     VectorXd eigenValues() const;
     
@@ -71,10 +91,16 @@ public:
      */
     bool isPure() const;
     
+    /**
+     * Returns Tr(p^2), computed as squared Frobenius norm in O(N^2)
+     */
+    double purity() const;
+    
     /**
      * Sets a new density matrix. Matrix should be square, self-adjoint, positive semi-definite, of trace one. Use it wisely.
      * Note: this function assumes to be called by unitary transform or measurement.
-     * Do not use it to simply replace current state with another one
+     * Do not use it to simply replace current state with another one: positivity is not checked here, that would need
+     * eigen decomposition on every gate
      */
     void setMatrix(MatrixXcd matr);
     
@@ -89,14 +115,17 @@ public:
 private:
     MatrixXcd _density;
     HilbertSpace _space;
-    VectorXd _eigenValues;
-    MatrixXcd _eigenVectors;
+    mutable bool _spectrumReady;
+    mutable VectorXd _eigenValues;
+    mutable MatrixXcd _eigenVectors;
     
     void _checkMatrixIsSquare(MatrixXcd matr);
     bool _checkMatrixIsSelfAdjoined(MatrixXcd matr);
     void _checkSpaceDimension(MatrixXcd matr, HilbertSpace space);
-    void _calculateEigenValuesAndVectors(MatrixXcd matr);
+    void _calculateEigenValuesAndVectors() const;
     void _checkMatrixIsDensityMatrix(MatrixXcd matr);
+    void _checkTrace(const MatrixXcd& matr, double tolerance = 1.0e-15);
+    static std::vector< std::vector< double > > _accumulateMarginals(const VectorXd& diagonal, const HilbertSpace& space, const std::vector< std::vector< int > >& subsets);
         
 };
 
@@ -0,0 +1,123 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "random_generator.h"
+
+#ifndef Constructors
+
+RandomGenerator::RandomGenerator(uint64_t seed, uint64_t stream)
+{
+    _key[0] = (uint32_t) seed;
+    _key[1] = (uint32_t) (seed >> 32);
+    _stream = stream;
+    _counter = 0;
+    _position = 2; // block is empty
+}
+
+RandomGenerator RandomGenerator::split(uint64_t index) const
+{
+    // child stream is Philox of (index, parent stream), so different indices never collide
+    uint32_t block[4] = { (uint32_t) index, (uint32_t) (index >> 32), (uint32_t) _stream, (uint32_t) (_stream >> 32) };
+    _philox(_key, block);
+    return RandomGenerator(seed(), ((uint64_t) block[1] << 32) | block[0]);
+}
+
+#endif
+
+#ifndef Philox
+
+void RandomGenerator::_philox(const uint32_t key[2], uint32_t counter[4])
+{
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+	uint64_t p0 = (uint64_t) 0xD2511F53 * counter[0];
+	uint64_t p1 = (uint64_t) 0xCD9E8D57 * counter[2];
+	uint32_t c0 = (uint32_t) (p1 >> 32) ^ counter[1] ^ k0;
+	uint32_t c2 = (uint32_t) (p0 >> 32) ^ counter[3] ^ k1;
+	counter[0] = c0;
+	counter[1] = (uint32_t) p1;
+	counter[2] = c2;
+	counter[3] = (uint32_t) p0;
+	k0 += 0x9E3779B9;
+	k1 += 0xBB67AE85;
+    }
+}
+
+void RandomGenerator::_generateBlock()
+{
+    _block[0] = (uint32_t) _counter;
+    _block[1] = (uint32_t) (_counter >> 32);
+    _block[2] = (uint32_t) _stream;
+    _block[3] = (uint32_t) (_stream >> 32);
+    _philox(_key, _block);
+    ++_counter;
+    _position = 0;
+}
+
+#endif
+
+uint64_t RandomGenerator::next()
+{
+    if (_position == 2)
+	_generateBlock();
+    uint64_t res = ((uint64_t) _block[2 * _position + 1] << 32) | _block[2 * _position];
+    ++_position;
+    return res;
+}
+
+double RandomGenerator::uniform()
+{
+    return (next() >> 11) * (1.0 / 9007199254740992.0); // 53 bits of mantissa, 2^-53
+}
+
+void RandomGenerator::discard(uint64_t n)
+{
+    if (n == 0) return;
+    // each block holds two numbers; first consume what is left in the current one
+    uint64_t left = 2 - _position;
+    if (n <= left) {
+	_position += n;
+	return;
+    }
+    n -= left;
+    _counter += (n - 1) / 2;
+    _generateBlock();
+    _position = 1 + (n - 1) % 2;
+}
+
+#ifndef Getters
+
+uint64_t RandomGenerator::seed() const
+{
+    return ((uint64_t) _key[1] << 32) | _key[0];
+}
+
+uint64_t RandomGenerator::stream() const
+{
+    return _stream;
+}
+
+#endif
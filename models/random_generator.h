@@ -0,0 +1,85 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef RANDOM_GENERATOR_H
+#define RANDOM_GENERATOR_H
+
+#include <stdint.h>
+
+/**
+ * Counter-based random generator (Philox4x32-10). Every number is a pure function of (seed, stream, counter),
+ * so the generator has no hidden global state, can jump ahead in O(1) and can be split into independent streams.
+ * 
+ * To get the same results regardless of thread count, give every shot (or job) its own stream via split(index)
+ * instead of sharing one generator between threads.
+ */
+class RandomGenerator
+{
+public:
+    /**
+     * Construct generator
+     * @param seed Seed of the simulation. The same seed always gives the same sequence
+     * @param stream Index of independent stream within the seed
+     */
+    RandomGenerator(uint64_t seed = 0, uint64_t stream = 0);
+    
+    /**
+     * Returns next 64 random bits
+     */
+    uint64_t next();
+    
+    /**
+     * Returns next random number uniformly distributed in [0, 1)
+     */
+    double uniform();
+    
+    /**
+     * Skip n numbers of the sequence without generating them
+     */
+    void discard(uint64_t n);
+    
+    /**
+     * Returns new generator with the same seed and independent stream derived from the current stream and index.
+     * Result depends only on seed, current stream and index, not on how many numbers were drawn already
+     * @param index Index of child stream, e.g. shot number or worker number
+     */
+    RandomGenerator split(uint64_t index) const;
+    
+    uint64_t seed() const;
+    uint64_t stream() const;
+    
+private:
+    uint32_t _key[2];
+    uint64_t _stream;
+    uint64_t _counter; // index of next block
+    uint32_t _block[4];
+    int _position; // number of already used 64-bit halves of _block
+    
+    void _generateBlock();
+    static void _philox(const uint32_t key[2], uint32_t counter[4]);
+};
+
+#endif // RANDOM_GENERATOR_H
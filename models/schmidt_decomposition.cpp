@@ -0,0 +1,149 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "schmidt_decomposition.h"
+#include "../Eigen/SVD"
+#include <stdexcept>
+
+#ifndef Constructors
+
+SchmidtDecomposition::SchmidtDecomposition(const VectorXcd& vec, const HilbertSpace& space, const std::vector< int >& subsystemsA, double threshold)
+{
+    _decompose(vec, space, subsystemsA, threshold);
+}
+
+SchmidtDecomposition::SchmidtDecomposition(const QuantumState& state, const std::vector< int >& subsystemsA, double threshold)
+{
+    if (!state.isPure())
+	throw std::invalid_argument("Schmidt decomposition exists only for pure states");
+    // p = |psi><psi|, so column j is psi * conj(psi_j); the column with the largest diagonal element gives psi up to
+    // phase without eigen decomposition
+    MatrixXcd density = state.densityMatrix();
+    int col;
+    density.diagonal().real().maxCoeff(&col);
+    _decompose(density.col(col) / sqrt(density(col, col).real()), state.space(), subsystemsA, threshold);
+}
+
+#endif
+
+void SchmidtDecomposition::_decompose(const VectorXcd& vec, const HilbertSpace& space, const std::vector< int >& subsystemsA, double threshold)
+{
+    if (vec.size() != space.totalDimension())
+	throw std::invalid_argument("Space total dimension shold be the same as vector size");
+    
+    int rank = space.rank();
+    std::vector< int > dims(rank), strides(rank, 1);
+    for (int i = rank - 1; i >= 0; --i) {
+	dims[i] = space.dimension(i);
+	if (i < rank - 1) strides[i] = strides[i + 1] * dims[i + 1];
+    }
+    
+    // weights of each subsystem digit in row (A) or column (B) index of reshaped matrix
+    std::vector< bool > inA(rank, false);
+    std::vector< int > rowWeights(rank, 0), colWeights(rank, 0);
+    int dimA = 1, dimB = 1;
+    for (int j = (int) subsystemsA.size() - 1; j >= 0; --j) {
+	int sub = subsystemsA[j];
+	if (sub < 0 || sub >= rank) throw std::invalid_argument("This state have not such subsystem");
+	if (inA[sub]) throw std::invalid_argument("Subsystem cannot be listed twice");
+	inA[sub] = true;
+	rowWeights[sub] = dimA;
+	dimA *= dims[sub];
+    }
+    for (int i = rank - 1; i >= 0; --i)
+	if (!inA[i]) {
+	    colWeights[i] = dimB;
+	    dimB *= dims[i];
+	}
+    
+    // gather amplitudes into d_A x d_B matrix walking digits as odometer
+    MatrixXcd reshaped(dimA, dimB);
+    std::vector< int > digits(rank, 0);
+    int row = 0, col = 0;
+    double norm = sqrt(vec.squaredNorm());
+    for (int index = 0; index < vec.size(); ++index) {
+	reshaped(row, col) = vec[index] / norm;
+	for (int i = rank - 1; i >= 0; --i) {
+	    row += rowWeights[i];
+	    col += colWeights[i];
+	    if (++digits[i] < dims[i]) break;
+	    row -= rowWeights[i] * dims[i];
+	    col -= colWeights[i] * dims[i];
+	    digits[i] = 0;
+	}
+    }
+    
+    JacobiSVD< MatrixXcd > svd(reshaped, ComputeThinU | ComputeThinV);
+    VectorXd values = svd.singularValues();
+    int kept = 0;
+    while (kept < values.size() && values[kept] > threshold)
+	++kept;
+    
+    _coefficients = values.head(kept);
+    _basisA = svd.matrixU().leftCols(kept);
+    _basisB = svd.matrixV().leftCols(kept).conjugate(); // M = U S V^+, so |b_k> is conjugated column of V
+    _truncationError = values.tail(values.size() - kept).squaredNorm();
+}
+
+#ifndef Getters
+
+VectorXd SchmidtDecomposition::coefficients() const
+{
+    return _coefficients;
+}
+
+MatrixXcd SchmidtDecomposition::basisA() const
+{
+    return _basisA;
+}
+
+MatrixXcd SchmidtDecomposition::basisB() const
+{
+    return _basisB;
+}
+
+int SchmidtDecomposition::rank() const
+{
+    return _coefficients.size();
+}
+
+double SchmidtDecomposition::truncationError() const
+{
+    return _truncationError;
+}
+
+double SchmidtDecomposition::entropy() const
+{
+    double res = 0;
+    for (int k = 0; k < _coefficients.size(); ++k) {
+	double p = _coefficients[k] * _coefficients[k];
+	if (p > 1.0e-30)
+	    res -= p * log2(p);
+    }
+    return res;
+}
+
+#endif
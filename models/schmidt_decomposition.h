@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef SCHMIDT_DECOMPOSITION_H
+#define SCHMIDT_DECOMPOSITION_H
+
+#include "../Eigen/Core"
+#include "hilbert_space.h"
+#include "quantum_state.h"
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * Schmidt decomposition of pure bipartite state: |psi> = sum of s_k |a_k>|b_k>, where part A consists of listed subsystems
+ * and part B of all the rest. Amplitudes are reshaped into d_A x d_B matrix by strides and decomposed with JacobiSVD,
+ * so density matrix of the state is never constructed
+ */
+class SchmidtDecomposition
+{
+public:
+    /**
+     * Decompose state vector
+     * @param vec State vector (can be unnormalized)
+     * @param space Space of the state
+     * @param subsystemsA Subsystems of part A; basis vectors of A are ordered as listed
+     * @param threshold Schmidt coefficients below or equal to it are dropped
+     */
+    SchmidtDecomposition(const VectorXcd& vec, const HilbertSpace& space, const std::vector< int >& subsystemsA, double threshold = 0);
+    
+    /**
+     * Decompose pure state. State vector is taken from the column of density matrix with the largest diagonal element
+     */
+    SchmidtDecomposition(const QuantumState& state, const std::vector< int >& subsystemsA, double threshold = 0);
+    
+    /**
+     * Schmidt coefficients s_k in decreasing order, their squares sum to 1 minus truncationError()
+     */
+    VectorXd coefficients() const;
+    
+    /**
+     * Vectors |a_k> as columns, in space of part A
+     */
+    MatrixXcd basisA() const;
+    
+    /**
+     * Vectors |b_k> as columns, in space of part B (remaining subsystems in increasing order)
+     */
+    MatrixXcd basisB() const;
+    
+    /**
+     * Number of kept coefficients
+     */
+    int rank() const;
+    
+    /**
+     * Sum of squares of dropped coefficients
+     */
+    double truncationError() const;
+    
+    /**
+     * Entanglement entropy -sum of s_k^2 * log2(s_k^2), in bits
+     */
+    double entropy() const;
+    
+private:
+    VectorXd _coefficients;
+    MatrixXcd _basisA, _basisB;
+    double _truncationError;
+    
+    void _decompose(const VectorXcd& vec, const HilbertSpace& space, const std::vector< int >& subsystemsA, double threshold);
+};
+
+#endif // SCHMIDT_DECOMPOSITION_H
@@ -0,0 +1,396 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "sharded_state_vector.h"
+#include "kronecker_tensor.h"
+#include <algorithm>
+#include <cerrno>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+// MSG_NOSIGNAL: writing to a dead peer fails with EPIPE instead of killing the process by SIGPIPE
+bool writeAll(int socket, const void* data, size_t bytes)
+{
+    const char* p = static_cast< const char* >(data);
+    while (bytes > 0) {
+	ssize_t done = send(socket, p, bytes, MSG_NOSIGNAL);
+	if (done <= 0) return false;
+	p += done;
+	bytes -= done;
+    }
+    return true;
+}
+
+bool readAll(int socket, void* data, size_t bytes)
+{
+    char* p = static_cast< char* >(data);
+    while (bytes > 0) {
+	ssize_t done = read(socket, p, bytes);
+	if (done <= 0) return false;
+	p += done;
+	bytes -= done;
+    }
+    return true;
+}
+}
+
+#ifndef Constructors
+
+ShardedStateVector::ShardedStateVector(const HilbertSpace& space, int workers, long long blockSize)
+{
+    int rank = space.rank();
+    _globalCount = 0;
+    while ((1 << _globalCount) < workers) ++_globalCount;
+    if (workers < 1 || (1 << _globalCount) != workers)
+	throw std::invalid_argument("Count of workers must be power of two");
+    if (_globalCount >= rank)
+	throw std::invalid_argument("At least one subsystem must stay local");
+    if (blockSize < 1)
+	throw std::invalid_argument("Exchange block must not be empty");
+    for (int s = 0; s < _globalCount; ++s)
+	if (space.dimension(s) != 2)
+	    throw std::invalid_argument("Global subsystems must be qubits");
+    
+    _space = space;
+    _workers = workers;
+    _slotDims = space.dimensions();
+    _size = 1;
+    for (int s = 0; s < rank; ++s) {
+	_size *= _slotDims[s];
+	_slotOf.push_back(s);
+	_subsystemIn.push_back(s);
+    }
+    _shardSize = _size / workers;
+    _blockSize = blockSize;
+    _lastUse.assign(rank, 0);
+    _time = 0;
+    _exchanges = 0;
+    
+    // shared anonymous mapping is inherited by forked workers: shards, then mailboxes of half shard, then counters and
+    // failure flag
+    _sharedBytes = (_size + _size / 2) * sizeof(std::complex< double >) + workers * sizeof(std::atomic< long long >) + sizeof(std::atomic< int >);
+    _shared = mmap(0, _sharedBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (_shared == MAP_FAILED)
+	throw std::runtime_error("Cannot allocate shared memory for state vector");
+    _amplitudes = static_cast< std::complex< double >* >(_shared);
+    _mailboxes = _amplitudes + _size;
+    _packed = reinterpret_cast< std::atomic< long long >* >(_mailboxes + _size / 2);
+    for (int w = 0; w < workers; ++w)
+	new (_packed + w) std::atomic< long long >(0);
+    _failed = new (_packed + workers) std::atomic< int >(0);
+    _amplitudes[0] = 1;
+    
+    for (int w = 0; w < workers; ++w) {
+	int pair[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+	    _shutdown();
+	    throw std::runtime_error("Cannot create socket for worker");
+	}
+	pid_t pid = fork();
+	if (pid < 0) {
+	    close(pair[0]);
+	    close(pair[1]);
+	    _shutdown();
+	    throw std::runtime_error("Cannot start worker process");
+	}
+	if (pid == 0) {
+	    close(pair[0]);
+	    for (int i = 0; i < _sockets.size(); ++i)
+		close(_sockets[i]);
+	    // exceptions must not unwind into the caller's code, it would go on running in two processes
+	    try {
+		_workerLoop(w, pair[1]);
+		_exit(0); // skip destructors and atexit handlers of the parent copy
+	    }
+	    catch (...) {
+	    }
+	    _exit(1);
+	}
+	close(pair[1]);
+	_sockets.push_back(pair[0]);
+	_pids.push_back(pid);
+    }
+}
+
+ShardedStateVector::~ShardedStateVector()
+{
+    _shutdown();
+}
+
+void ShardedStateVector::_shutdown()
+{
+    // also called when constructor fails, so only started workers are stopped
+    Command quit = Command();
+    quit.type = Quit;
+    for (int w = 0; w < _pids.size(); ++w) {
+	writeAll(_sockets[w], &quit, sizeof(quit));
+	close(_sockets[w]);
+	waitpid(_pids[w], 0, 0);
+    }
+    _sockets.clear();
+    _pids.clear();
+    munmap(_shared, _sharedBytes);
+}
+
+#endif
+
+#ifndef Workers
+
+void ShardedStateVector::_workerLoop(int worker, int socket)
+{
+    std::complex< double >* shard = _amplitudes + worker * _shardSize;
+    std::vector< uint > localDims(_slotDims.begin() + _globalCount, _slotDims.end());
+    Command command;
+    char done = 1;
+    while (readAll(socket, &command, sizeof(command)) && command.type != Quit) {
+	if (command.type == Apply) {
+	    int size = 1;
+	    for (int i = 0; i < command.count; ++i)
+		size *= localDims[command.subsystems[i]];
+	    MatrixXcd matrix(size, size);
+	    if (!readAll(socket, matrix.data(), size * size * sizeof(std::complex< double >)))
+		break;
+	    KroneckerTensor::applyToSubsystems(matrix, std::vector< int >(command.subsystems, command.subsystems + command.count), localDims, shard, 0, _shardSize);
+	}
+	else _exchange(worker, command.globalBit, command.localSlot);
+	if (!writeAll(socket, &done, 1))
+	    break;
+    }
+    close(socket);
+}
+
+void ShardedStateVector::_exchange(int worker, int globalBit, int localSlot)
+{
+    // amplitude with digits (i, j) in (global, local) moves to (j, i): worker with global digit i sends runs with local
+    // digit 1 - i to partner and gets partner's runs into their place
+    long long run = 1;
+    for (int s = _slotDims.size() - 1; s > localSlot; --s)
+	run *= _slotDims[s];
+    int digit = (worker >> globalBit) & 1, partner = worker ^ (1 << globalBit);
+    std::complex< double >* shard = _amplitudes + worker * _shardSize;
+    std::complex< double >* outbox = _mailboxes + worker * (_shardSize / 2);
+    std::complex< double >* inbox = _mailboxes + partner * (_shardSize / 2);
+    long long half = _shardSize / 2, blocks = (half + _blockSize - 1) / _blockSize, unpacked = 0;
+    
+    // element k of mailbox is element of shard at (k / run) * 2 * run + (1 - digit) * run + k % run
+    for (long long block = 0; block < blocks || unpacked < blocks; ) {
+	if (block < blocks) {
+	    for (long long k = block * _blockSize; k < std::min(half, (block + 1) * _blockSize); ++k)
+		outbox[k] = shard[(k / run) * 2 * run + (1 - digit) * run + k % run];
+	    _packed[worker].store(++block, std::memory_order_release);
+	}
+	// own block must be packed before the same place is overwritten
+	long long ready = std::min(block, _packed[partner].load(std::memory_order_acquire));
+	if (ready == unpacked && block == blocks) {
+	    // partner may be dead, then the parent raises the flag and the state is abandoned
+	    if (_failed->load())
+		return;
+	    std::this_thread::yield();
+	}
+	for (; unpacked < ready; ++unpacked)
+	    for (long long k = unpacked * _blockSize; k < std::min(half, (unpacked + 1) * _blockSize); ++k)
+		shard[(k / run) * 2 * run + (1 - digit) * run + k % run] = inbox[k];
+    }
+}
+
+#endif
+
+#ifndef Performing
+
+void ShardedStateVector::_send(const Command& command, const MatrixXcd* matrix)
+{
+    if (_failed->load())
+	throw std::runtime_error("Connection with worker is lost");
+    for (int w = 0; w < _workers; ++w)
+	if (!writeAll(_sockets[w], &command, sizeof(command)) ||
+	    (matrix != 0 && !writeAll(_sockets[w], matrix->data(), matrix->size() * sizeof(std::complex< double >)))) {
+	    _failed->store(1);
+	    throw std::runtime_error("Connection with worker is lost");
+	}
+    
+    // every command ends with barrier, so mailboxes and counters are free afterwards. Closed socket means dead worker:
+    // the flag releases its partner waiting in exchange, so the others still answer
+    std::vector< pollfd > waiting(_workers);
+    for (int w = 0; w < _workers; ++w) {
+	waiting[w].fd = _sockets[w];
+	waiting[w].events = POLLIN;
+    }
+    while (!waiting.empty()) {
+	if (poll(&waiting[0], waiting.size(), -1) < 0) {
+	    if (errno == EINTR) continue;
+	    _failed->store(1);
+	    break;
+	}
+	for (int i = (int) waiting.size() - 1; i >= 0; --i) {
+	    if (waiting[i].revents == 0) continue;
+	    char done;
+	    if (!readAll(waiting[i].fd, &done, 1))
+		_failed->store(1);
+	    waiting.erase(waiting.begin() + i);
+	}
+    }
+    if (_failed->load())
+	throw std::runtime_error("Connection with worker is lost");
+}
+
+void ShardedStateVector::_swapSlots(int global, int local)
+{
+    for (int w = 0; w < _workers; ++w)
+	_packed[w].store(0);
+    Command command = Command();
+    command.type = Exchange;
+    command.globalBit = _globalCount - 1 - global;
+    command.localSlot = local;
+    _send(command, 0);
+    
+    int a = _subsystemIn[global], b = _subsystemIn[local];
+    std::swap(_subsystemIn[global], _subsystemIn[local]);
+    _slotOf[a] = local;
+    _slotOf[b] = global;
+    ++_exchanges;
+}
+
+void ShardedStateVector::apply(const UnitaryTransformation& gate, const std::vector< int >& subsystems)
+{
+    std::vector< uint > dims;
+    for (int i = 0; i < subsystems.size(); ++i) {
+	if (subsystems[i] < 0 || subsystems[i] >= _slotOf.size())
+	    throw std::invalid_argument("This state have not such subsystem");
+	dims.push_back(_space.dimension(subsystems[i]));
+    }
+    if (gate.space().totalDimension() != HilbertSpace(dims).totalDimension() || (gate.space().rank() > 1 && gate.space() != HilbertSpace(dims)))
+	throw std::invalid_argument("Space of gate must match dimensions of subsystems");
+    if (subsystems.size() > std::min< int >(8, _slotOf.size() - _globalCount))
+	throw std::invalid_argument("Gate is wider than shard");
+    
+    // global subsystem is swapped with local qubit not used for the longest time
+    ++_time;
+    for (int i = 0; i < subsystems.size(); ++i)
+	_lastUse[subsystems[i]] = _time;
+    for (int i = 0; i < subsystems.size(); ++i) {
+	if (_slotOf[subsystems[i]] >= _globalCount) continue;
+	int victim = -1;
+	for (int slot = _globalCount; slot < _slotDims.size(); ++slot)
+	    if (_slotDims[slot] == 2 && _lastUse[_subsystemIn[slot]] != _time && (victim < 0 || _lastUse[_subsystemIn[slot]] < _lastUse[_subsystemIn[victim]]))
+		victim = slot;
+	if (victim < 0)
+	    throw std::runtime_error("No local qubit to swap with");
+	_swapSlots(_slotOf[subsystems[i]], victim);
+    }
+    
+    Command command = Command();
+    command.type = Apply;
+    command.count = subsystems.size();
+    for (int i = 0; i < subsystems.size(); ++i)
+	command.subsystems[i] = _slotOf[subsystems[i]] - _globalCount;
+    MatrixXcd matrix = gate.transformMatrix();
+    _send(command, &matrix);
+}
+
+void ShardedStateVector::apply(const Circuit& circuit)
+{
+    if (circuit.space() != _space)
+	throw std::invalid_argument("State and circuit spaces are different");
+    for (int g = 0; g < circuit.gatesCount(); ++g) {
+	const CircuitGate& gate = circuit.gate(g);
+	std::vector< uint > dims;
+	for (int i = 0; i < gate.subsystems.size(); ++i)
+	    dims.push_back(_space.dimension(gate.subsystems[i]));
+	apply(UnitaryTransformation(gate.matrix, HilbertSpace(dims)), gate.subsystems);
+    }
+}
+
+#endif
+
+#ifndef Getters
+
+long long ShardedStateVector::_index(const std::vector< int >& digits) const
+{
+    if (digits.size() != _slotOf.size())
+	throw std::invalid_argument("Basis state must have digit for every subsystem");
+    long long index = 0, stride = 1;
+    for (int slot = _slotDims.size() - 1; slot >= 0; --slot) {
+	int digit = digits[_subsystemIn[slot]];
+	if (digit < 0 || digit >= _slotDims[slot])
+	    throw std::invalid_argument("Digit is out of subsystem dimension");
+	index += digit * stride;
+	stride *= _slotDims[slot];
+    }
+    return index;
+}
+
+std::complex< double > ShardedStateVector::amplitude(const std::vector< int >& digits) const
+{
+    return _amplitudes[_index(digits)];
+}
+
+VectorXcd ShardedStateVector::toVector() const
+{
+    VectorXcd res(_size);
+    std::vector< int > digits(_slotOf.size(), 0);
+    for (long long i = 0; i < _size; ++i) {
+	res[i] = _amplitudes[_index(digits)];
+	for (int s = (int) digits.size() - 1; s >= 0; --s) {
+	    if (++digits[s] < _space.dimension(s)) break;
+	    digits[s] = 0;
+	}
+    }
+    return res;
+}
+
+HilbertSpace ShardedStateVector::space() const
+{
+    return _space;
+}
+
+int ShardedStateVector::workersCount() const
+{
+    return _workers;
+}
+
+pid_t ShardedStateVector::workerPid(int worker) const
+{
+    return _pids.at(worker);
+}
+
+std::vector< int > ShardedStateVector::layout() const
+{
+    return _slotOf;
+}
+
+int ShardedStateVector::exchangesCount() const
+{
+    return _exchanges;
+}
+
+#endif
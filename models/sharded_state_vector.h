@@ -0,0 +1,134 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef SHARDED_STATE_VECTOR_H
+#define SHARDED_STATE_VECTOR_H
+
+#include "../Eigen/Core"
+#include "hilbert_space.h"
+#include "circuit.h"
+#include "unitary_transformation.h"
+#include <atomic>
+#include <complex>
+#include <vector>
+#include <sys/types.h>
+
+using namespace Eigen;
+
+/**
+ * State vector split into shards between worker processes on one host, standing in for nodes of a cluster.
+ * The leading subsystems (qubits) are global: their digits number shards. Every worker owns its shard in shared memory
+ * and gets commands through Unix socket. Gate on local subsystems is run by all workers independently; global qubit
+ * needed by a gate is first swapped with local one: pair of workers exchanges halves of their shards through
+ * mailboxes in shared memory, block by block, so that the partner unpacks while the worker still packs. Gates are not
+ * overlapped with exchange: the gate that needs the global qubit starts after the barrier that ends the exchange
+ */
+class ShardedStateVector
+{
+public:
+    /**
+     * Fork workers and put |0...0> into shards
+     * @param space Space of the state
+     * @param workers Count of workers, power of two; log2(workers) leading subsystems must be qubits and at least one
+     * subsystem must stay local
+     * @param blockSize Amplitudes packed between notifications of partner during exchange; unpacking of one block
+     * overlaps packing of the next one
+     */
+    ShardedStateVector(const HilbertSpace& space, int workers, long long blockSize = 4096);
+    ~ShardedStateVector();
+    
+    /**
+     * Apply gate, see UnitaryTransformation::applyTo()
+     * @param subsystems Subsystems gate acts on, in order of its space
+     */
+    void apply(const UnitaryTransformation& gate, const std::vector< int >& subsystems);
+    void apply(const Circuit& circuit);
+    
+    std::complex< double > amplitude(const std::vector< int >& digits) const;
+    
+    /**
+     * Whole vector in order of subsystems. Use it only for small spaces
+     */
+    VectorXcd toVector() const;
+    
+    HilbertSpace space() const;
+    int workersCount() const;
+    
+    /**
+     * Process id of worker, for monitoring. When a worker dies, calls that need workers throw std::runtime_error
+     */
+    pid_t workerPid(int worker) const;
+    
+    /**
+     * Slot of every subsystem, the first log2(workers) slots are global
+     */
+    std::vector< int > layout() const;
+    
+    /**
+     * Count of half-shard exchanges
+     */
+    int exchangesCount() const;
+    
+private:
+    struct Command
+    {
+	int type;
+	int count; // subsystems of gate
+	int subsystems[8];
+	int globalBit, localSlot;
+    };
+    enum CommandType {Apply, Exchange, Quit};
+    
+    HilbertSpace _space;
+    int _workers, _globalCount;
+    long long _size, _shardSize, _blockSize;
+    std::vector< uint > _slotDims;
+    std::vector< int > _slotOf, _subsystemIn;
+    std::vector< long long > _lastUse;
+    long long _time;
+    int _exchanges;
+    
+    void* _shared;
+    size_t _sharedBytes;
+    std::complex< double >* _amplitudes;
+    std::complex< double >* _mailboxes;
+    std::atomic< long long >* _packed; // count of packed blocks of every worker
+    std::atomic< int >* _failed; // set by the parent when a worker is lost, stops partners waiting in exchange
+    std::vector< int > _sockets;
+    std::vector< pid_t > _pids;
+    
+    void _shutdown();
+    void _send(const Command& command, const MatrixXcd* matrix);
+    void _workerLoop(int worker, int socket);
+    void _exchange(int worker, int globalBit, int localSlot);
+    void _swapSlots(int global, int local);
+    long long _index(const std::vector< int >& digits) const;
+    
+    ShardedStateVector(const ShardedStateVector&);
+    ShardedStateVector& operator=(const ShardedStateVector&);
+};
+
+#endif // SHARDED_STATE_VECTOR_H
@@ -0,0 +1,255 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "split_complex.h"
+#include "kronecker_tensor.h"
+#include <stdexcept>
+
+#ifndef Kernel
+
+void SplitStateVector::applyToSubsystems(const MatrixXcd& op, const std::vector< int >& subsystems, const std::vector< uint >& dimensions, double* re, double* im)
+{
+    std::vector< long long > strides(dimensions.size(), 1);
+    for (int i = (int) dimensions.size() - 2; i >= 0; --i)
+	strides[i] = strides[i + 1] * dimensions[i + 1];
+    long long size = dimensions.empty() ? 0 : strides[0] * dimensions[0];
+    int localDim = KroneckerTensor::localDimension(subsystems, dimensions);
+    if (op.rows() != localDim || op.cols() != localDim)
+	throw std::invalid_argument("Operator size does not match subsystems dimensions");
+    MatrixXd opRe = op.real(), opIm = op.imag();
+    
+    if (localDim == 2) {
+	// qubit: butterfly over the two halves of every group of 2 * stride, both outputs from the same pair of inputs
+	long long stride = strides[subsystems[0]];
+	const double aRe = opRe(0, 0), aIm = opIm(0, 0), bRe = opRe(0, 1), bIm = opIm(0, 1);
+	const double cRe = opRe(1, 0), cIm = opIm(1, 0), dRe = opRe(1, 1), dIm = opIm(1, 1);
+	for (long long high = 0; high < size; high += 2 * stride) {
+	    double* xRe = re + high;
+	    double* xIm = im + high;
+	    double* yRe = xRe + stride;
+	    double* yIm = xIm + stride;
+	    for (long long low = 0; low < stride; ++low) {
+		double r0 = xRe[low], i0 = xIm[low], r1 = yRe[low], i1 = yIm[low];
+		xRe[low] = aRe * r0 - aIm * i0 + bRe * r1 - bIm * i1;
+		xIm[low] = aRe * i0 + aIm * r0 + bRe * i1 + bIm * r1;
+		yRe[low] = cRe * r0 - cIm * i0 + dRe * r1 - dIm * i1;
+		yIm[low] = cRe * i0 + cIm * r0 + dRe * i1 + dIm * r1;
+	    }
+	}
+	return;
+    }
+    
+    if (subsystems.size() == 1) {
+	// amplitudes with the same digit of subsystem form contiguous runs of stride, inner loop is over a run
+	long long stride = strides[subsystems[0]];
+	int dim = localDim;
+	std::vector< double > inRe(dim * stride), inIm(dim * stride);
+	for (long long high = 0; high < size; high += dim * stride) {
+	    std::copy(re + high, re + high + dim * stride, inRe.begin());
+	    std::copy(im + high, im + high + dim * stride, inIm.begin());
+	    for (int row = 0; row < dim; ++row) {
+		double* outRe = re + high + row * stride;
+		double* outIm = im + high + row * stride;
+		for (long long low = 0; low < stride; ++low)
+		    outRe[low] = outIm[low] = 0;
+		for (int col = 0; col < dim; ++col) {
+		    double a = opRe(row, col), b = opIm(row, col);
+		    const double* xRe = &inRe[col * stride];
+		    const double* xIm = &inIm[col * stride];
+		    for (long long low = 0; low < stride; ++low) {
+			outRe[low] += a * xRe[low] - b * xIm[low];
+			outIm[low] += a * xIm[low] + b * xRe[low];
+		    }
+		}
+	    }
+	}
+	return;
+    }
+    
+    std::vector< long long > offsets(localDim, 0);
+    for (int a = 0; a < localDim; ++a) {
+	int rest = a;
+	for (int i = (int) subsystems.size() - 1; i >= 0; --i) {
+	    offsets[a] += (rest % dimensions[subsystems[i]]) * strides[subsystems[i]];
+	    rest /= dimensions[subsystems[i]];
+	}
+    }
+    std::vector< bool > isTarget(dimensions.size(), false);
+    for (int i = 0; i < subsystems.size(); ++i)
+	isTarget[subsystems[i]] = true;
+    std::vector< int > digits(dimensions.size(), 0);
+    std::vector< double > inRe(localDim), inIm(localDim);
+    long long base = 0;
+    while (true) {
+	for (int a = 0; a < localDim; ++a) {
+	    inRe[a] = re[base + offsets[a]];
+	    inIm[a] = im[base + offsets[a]];
+	}
+	for (int a = 0; a < localDim; ++a) {
+	    double sumRe = 0, sumIm = 0;
+	    for (int b = 0; b < localDim; ++b) {
+		sumRe += opRe(a, b) * inRe[b] - opIm(a, b) * inIm[b];
+		sumIm += opRe(a, b) * inIm[b] + opIm(a, b) * inRe[b];
+	    }
+	    re[base + offsets[a]] = sumRe;
+	    im[base + offsets[a]] = sumIm;
+	}
+	// next base: increment digits of untouched subsystems, lowest first
+	int i = (int) dimensions.size() - 1;
+	for (; i >= 0; --i) {
+	    if (isTarget[i]) continue;
+	    if (++digits[i] < dimensions[i]) {
+		base += strides[i];
+		break;
+	    }
+	    base -= (dimensions[i] - 1) * strides[i];
+	    digits[i] = 0;
+	}
+	if (i < 0) break;
+    }
+}
+
+#endif
+
+#ifndef Vector
+
+SplitStateVector::SplitStateVector(const VectorXcd& vec, const HilbertSpace& space)
+{
+    if (vec.size() != space.totalDimension())
+	throw std::invalid_argument("Space total dimension shold be the same as vector size");
+    _re = vec.real();
+    _im = vec.imag();
+    _space = space;
+}
+
+VectorXcd SplitStateVector::toInterleaved() const
+{
+    VectorXcd res(_re.size());
+    res.real() = _re;
+    res.imag() = _im;
+    return res;
+}
+
+void SplitStateVector::apply(const MatrixXcd& op, const std::vector< int >& subsystems)
+{
+    applyToSubsystems(op, subsystems, _space.dimensions(), _re.data(), _im.data());
+}
+
+VectorXd SplitStateVector::probabilities() const
+{
+    return _re.cwiseAbs2() + _im.cwiseAbs2();
+}
+
+double SplitStateVector::expectation(const MatrixXcd& op, const std::vector< int >& subsystems) const
+{
+    // Re <psi|O psi> = re . re' + im . im'
+    SplitStateVector applied = *this;
+    applied.apply(op, subsystems);
+    return _re.dot(applied._re) + _im.dot(applied._im);
+}
+
+const VectorXd& SplitStateVector::real() const
+{
+    return _re;
+}
+
+const VectorXd& SplitStateVector::imag() const
+{
+    return _im;
+}
+
+HilbertSpace SplitStateVector::space() const
+{
+    return _space;
+}
+
+#endif
+
+#ifndef Density
+
+SplitDensityMatrix::SplitDensityMatrix(const MatrixXcd& density, const HilbertSpace& space)
+{
+    if (density.rows() != space.totalDimension() || density.cols() != density.rows())
+	throw std::invalid_argument("Space total dimension shold be the same as matrix is");
+    _re = density.real();
+    _im = density.imag();
+    _space = space;
+}
+
+MatrixXcd SplitDensityMatrix::toInterleaved() const
+{
+    MatrixXcd res(_re.rows(), _re.cols());
+    res.real() = _re;
+    res.imag() = _im;
+    return res;
+}
+
+void SplitDensityMatrix::_applyLeft(const MatrixXcd& op, const std::vector< int >& subsystems, MatrixXd& re, MatrixXd& im) const
+{
+    std::vector< uint > dims = _space.dimensions();
+    for (int col = 0; col < re.cols(); ++col)
+	SplitStateVector::applyToSubsystems(op, subsystems, dims, re.col(col).data(), im.col(col).data());
+}
+
+void SplitDensityMatrix::apply(const MatrixXcd& op, const std::vector< int >& subsystems)
+{
+    // U * p * U^+ = U * (U * p)^+ since p is Hermit; adjoint of split matrix is (re^T, -im^T)
+    _applyLeft(op, subsystems, _re, _im);
+    _re.transposeInPlace();
+    _im.transposeInPlace();
+    _im = -_im;
+    _applyLeft(op, subsystems, _re, _im);
+}
+
+VectorXd SplitDensityMatrix::probabilities() const
+{
+    return _re.diagonal();
+}
+
+double SplitDensityMatrix::expectation(const MatrixXcd& op, const std::vector< int >& subsystems) const
+{
+    // Tr(O p) = Re sum of diagonal of O * p
+    MatrixXd re = _re, im = _im;
+    _applyLeft(op, subsystems, re, im);
+    return re.trace();
+}
+
+const MatrixXd& SplitDensityMatrix::real() const
+{
+    return _re;
+}
+
+const MatrixXd& SplitDensityMatrix::imag() const
+{
+    return _im;
+}
+
+HilbertSpace SplitDensityMatrix::space() const
+{
+    return _space;
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef SPLIT_COMPLEX_H
+#define SPLIT_COMPLEX_H
+
+#include "../Eigen/Core"
+#include "hilbert_space.h"
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * State vector with real and imaginary parts in separate arrays (structure of arrays). Complex multiply then needs no
+ * shuffles: loops over contiguous amplitudes are plain real arithmetic the compiler vectorizes.
+ * Conversion from and to interleaved VectorXcd is O(N)
+ */
+class SplitStateVector
+{
+public:
+    SplitStateVector(const VectorXcd& vec, const HilbertSpace& space);
+    VectorXcd toInterleaved() const;
+    
+    /**
+     * Apply operator to listed subsystems, see KroneckerTensor::applyToSubsystems()
+     */
+    void apply(const MatrixXcd& op, const std::vector< int >& subsystems);
+    
+    /**
+     * Probabilities of computational basis states, |re|^2 + |im|^2
+     */
+    VectorXd probabilities() const;
+    
+    /**
+     * Expectation <psi| O |psi> of local operator
+     */
+    double expectation(const MatrixXcd& op, const std::vector< int >& subsystems) const;
+    
+    const VectorXd& real() const;
+    const VectorXd& imag() const;
+    HilbertSpace space() const;
+    
+    /**
+     * Kernel used by split vectors and matrices: apply operator to one column given by its real and imaginary parts
+     */
+    static void applyToSubsystems(const MatrixXcd& op, const std::vector< int >& subsystems, const std::vector< uint >& dimensions, double* re, double* im);
+    
+private:
+    VectorXd _re, _im;
+    HilbertSpace _space;
+};
+
+/**
+ * Density matrix with real and imaginary parts in separate matrices, see SplitStateVector
+ */
+class SplitDensityMatrix
+{
+public:
+    SplitDensityMatrix(const MatrixXcd& density, const HilbertSpace& space);
+    MatrixXcd toInterleaved() const;
+    
+    /**
+     * p = U * p * U^+ for operator on listed subsystems
+     */
+    void apply(const MatrixXcd& op, const std::vector< int >& subsystems);
+    
+    /**
+     * Probabilities of computational basis states, real part of diagonal
+     */
+    VectorXd probabilities() const;
+    
+    /**
+     * Expectation Tr(p * O) of local Hermit operator
+     */
+    double expectation(const MatrixXcd& op, const std::vector< int >& subsystems) const;
+    
+    const MatrixXd& real() const;
+    const MatrixXd& imag() const;
+    HilbertSpace space() const;
+    
+private:
+    MatrixXd _re, _im;
+    HilbertSpace _space;
+    
+    void _applyLeft(const MatrixXcd& op, const std::vector< int >& subsystems, MatrixXd& re, MatrixXd& im) const;
+};
+
+#endif // SPLIT_COMPLEX_H
@@ -0,0 +1,153 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "state_batch.h"
+#include "kronecker_tensor.h"
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef Constructors
+
+StateBatch::StateBatch(const HilbertSpace& space, int size)
+{
+    if (size < 1)
+	throw std::invalid_argument("Batch cannot be empty");
+    _space = space;
+    _states = MatrixXcd::Zero(space.totalDimension(), size);
+    _states.row(0).setOnes();
+}
+
+StateBatch::StateBatch(const HilbertSpace& space, const MatrixXcd& states)
+{
+    if (states.rows() != space.totalDimension() || states.cols() < 1)
+	throw std::invalid_argument("Space total dimension shold be the same as vector size");
+    _space = space;
+    _states = states;
+}
+
+StateBatch StateBatch::basisInputs(const HilbertSpace& space)
+{
+    return StateBatch(space, MatrixXcd::Identity(space.totalDimension(), space.totalDimension()));
+}
+
+#endif
+
+#ifndef Performing
+
+void StateBatch::apply(const MatrixXcd& op, const std::vector< int >& subsystems)
+{
+    int rank = _space.rank(), localDim = 1;
+    std::vector< int > sorted = subsystems;
+    std::sort(sorted.begin(), sorted.end());
+    for (int i = 0; i < sorted.size(); ++i) {
+	if (sorted[i] < 0 || sorted[i] >= rank || (i > 0 && sorted[i] == sorted[i - 1]))
+	    throw std::invalid_argument("Wrong list of subsystems");
+	localDim *= _space.dimension(sorted[i]);
+    }
+    if (op.rows() != localDim || op.cols() != localDim)
+	throw std::invalid_argument("Operator size does not match subsystems dimensions");
+    if (sorted.back() - sorted.front() + 1 != sorted.size()) {
+	KroneckerTensor::applyToSubsystems(op, subsystems, _space.dimensions(), _states);
+	return;
+    }
+    
+    // bring operator to increasing order of subsystems: sorted local index -> index in order of gate
+    std::vector< int > map(localDim);
+    for (int a = 0; a < localDim; ++a) {
+	int rest = a, index = 0;
+	std::vector< int > digits(rank);
+	for (int i = (int) sorted.size() - 1; i >= 0; --i) {
+	    digits[sorted[i]] = rest % _space.dimension(sorted[i]);
+	    rest /= _space.dimension(sorted[i]);
+	}
+	for (int i = 0; i < subsystems.size(); ++i)
+	    index = index * _space.dimension(subsystems[i]) + digits[subsystems[i]];
+	map[a] = index;
+    }
+    MatrixXcd local(localDim, localDim);
+    for (int col = 0; col < localDim; ++col)
+	for (int row = 0; row < localDim; ++row)
+	    local(row, col) = op(map[row], map[col]);
+    
+    // index of amplitude is (high, local, low); low part is contiguous, so (low x local) slice is a column-major matrix
+    long long stride = 1;
+    for (int s = rank - 1; s > sorted.back(); --s)
+	stride *= _space.dimension(s);
+    long long slice = stride * localDim, total = (long long) _states.rows() * _states.cols();
+    if (stride == 1) {
+	Map< MatrixXcd > all(_states.data(), localDim, total / localDim);
+	MatrixXcd res = local * all;
+	all = res;
+	return;
+    }
+    MatrixXcd transposed = local.transpose(), res(stride, localDim);
+    for (long long begin = 0; begin < total; begin += slice) {
+	Map< MatrixXcd > part(_states.data() + begin, stride, localDim);
+	res.noalias() = part * transposed;
+	part = res;
+    }
+}
+
+void StateBatch::apply(const UnitaryTransformation& gate, const std::vector< int >& subsystems)
+{
+    apply(gate.transformMatrix(), subsystems);
+}
+
+void StateBatch::apply(const Circuit& circuit)
+{
+    if (circuit.space() != _space)
+	throw std::invalid_argument("Batch and circuit spaces are different");
+    for (int g = 0; g < circuit.gatesCount(); ++g)
+	apply(circuit.gate(g).matrix, circuit.gate(g).subsystems);
+}
+
+#endif
+
+#ifndef Getters
+
+int StateBatch::size() const
+{
+    return _states.cols();
+}
+
+HilbertSpace StateBatch::space() const
+{
+    return _space;
+}
+
+const MatrixXcd& StateBatch::states() const
+{
+    return _states;
+}
+
+VectorXcd StateBatch::state(int index) const
+{
+    if (index < 0 || index >= _states.cols())
+	throw std::invalid_argument("Batch have not such state");
+    return _states.col(index);
+}
+
+#endif
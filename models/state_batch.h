@@ -0,0 +1,81 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef STATE_BATCH_H
+#define STATE_BATCH_H
+
+#include "../Eigen/Core"
+#include "hilbert_space.h"
+#include "circuit.h"
+#include "unitary_transformation.h"
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * Batch of state vectors of the same space packed as columns of one matrix. Gate on adjacent subsystems is applied to
+ * all of them by matrix products over contiguous memory: every column is viewed as set of (lower stride x gate size)
+ * slices, each slice is multiplied by transposed gate matrix; gate on the last subsystems is one product for the whole
+ * batch. Gate on subsystems that are not adjacent goes through KroneckerTensor::applyToSubsystems()
+ */
+class StateBatch
+{
+public:
+    /**
+     * Batch of |0...0> states
+     */
+    StateBatch(const HilbertSpace& space, int size);
+    
+    /**
+     * Batch of given state vectors (columns), they are not normalized
+     */
+    StateBatch(const HilbertSpace& space, const MatrixXcd& states);
+    
+    /**
+     * Batch of all computational basis states in order of their indexes, i.e. identity matrix. After circuit it holds
+     * the circuit matrix
+     */
+    static StateBatch basisInputs(const HilbertSpace& space);
+    
+    /**
+     * Apply operator to listed subsystems of every state
+     * @param subsystems Subsystems in order of operator space, the first one is the most significant
+     */
+    void apply(const MatrixXcd& op, const std::vector< int >& subsystems);
+    void apply(const UnitaryTransformation& gate, const std::vector< int >& subsystems);
+    void apply(const Circuit& circuit);
+    
+    int size() const;
+    HilbertSpace space() const;
+    const MatrixXcd& states() const;
+    VectorXcd state(int index) const;
+    
+private:
+    HilbertSpace _space;
+    MatrixXcd _states;
+};
+
+#endif // STATE_BATCH_H
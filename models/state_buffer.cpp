@@ -0,0 +1,239 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "state_buffer.h"
+#include "kronecker_tensor.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+const long long hugePageSize = 2 << 20;
+const int policyPreferred = 1, policyInterleave = 3; // MPOL_* of linux/mempolicy.h
+
+// mbind is called directly, placement is only a hint and its failure (no NUMA support) is ignored
+void bindToNodes(void* address, size_t bytes, int mode, const std::vector< int >& nodes)
+{
+#ifdef SYS_mbind
+    unsigned long mask[16] = {0};
+    for (int i = 0; i < nodes.size(); ++i)
+	if (nodes[i] < 16 * 8 * sizeof(unsigned long))
+	    mask[nodes[i] / (8 * sizeof(unsigned long))] |= 1ul << (nodes[i] % (8 * sizeof(unsigned long)));
+    syscall(SYS_mbind, address, bytes, mode, mask, 16 * 8 * sizeof(unsigned long), 0);
+#endif
+}
+
+void pinToCpus(const std::vector< int >& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < cpus.size(); ++i)
+	CPU_SET(cpus[i], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// list like "0-3,8-11"
+std::vector< int > parseCpuList(const std::string& list)
+{
+    std::vector< int > res;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+	if (item.empty() || item == "\n") continue;
+	int first = 0, last = 0;
+	if (sscanf(item.c_str(), "%d-%d", &first, &last) == 2)
+	    for (int cpu = first; cpu <= last; ++cpu) res.push_back(cpu);
+	else if (sscanf(item.c_str(), "%d", &first) == 1)
+	    res.push_back(first);
+    }
+    return res;
+}
+}
+
+#ifndef Constructors
+
+StateBuffer::StateBuffer(long long size, Placement placement, int threads, bool hugePages)
+{
+    if (size <= 0)
+	throw std::invalid_argument("Size of buffer must be positive");
+    _size = size;
+    _bytes = size * sizeof(std::complex< double >);
+    void* data = mmap(0, _bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (data == MAP_FAILED)
+	throw std::bad_alloc();
+    _data = static_cast< std::complex< double >* >(data);
+#ifdef MADV_HUGEPAGE
+    if (hugePages)
+	madvise(data, _bytes, MADV_HUGEPAGE);
+#endif
+    
+    // workers are spread over nodes in blocks, so ranges of one node are adjacent; range bounds are aligned to pages
+    _nodeCpus = nodeCpus();
+    if (threads <= 0)
+	threads = std::max(1u, std::thread::hardware_concurrency());
+    long long align = (hugePages ? hugePageSize : sysconf(_SC_PAGESIZE)) / sizeof(std::complex< double >);
+    for (int t = 0; t < threads; ++t) {
+	_threadNodes.push_back((long long) t * _nodeCpus.size() / threads);
+	_ranges.push_back(std::min(size, (size * t / threads) / align * align));
+    }
+    _ranges.push_back(size);
+    _place(placement);
+}
+
+StateBuffer::~StateBuffer()
+{
+    munmap(_data, _bytes);
+}
+
+#endif
+
+void StateBuffer::_place(Placement placement)
+{
+    if (placement == Interleave) {
+	std::vector< int > nodes;
+	for (int n = 0; n < _nodeCpus.size(); ++n) nodes.push_back(n);
+	bindToNodes(_data, _bytes, policyInterleave, nodes);
+    }
+    if (placement == Partition)
+	for (int t = 0; t < threadsCount(); ++t)
+	    if (_ranges[t + 1] > _ranges[t])
+		bindToNodes(_data + _ranges[t], (_ranges[t + 1] - _ranges[t]) * sizeof(std::complex< double >), policyPreferred, std::vector< int >(1, _threadNodes[t]));
+    
+    // first touch by pinned workers puts pages on their nodes
+    std::complex< double >* data = _data;
+    parallelFor([data](int, long long begin, long long end) {
+	memset(static_cast< void* >(data + begin), 0, (end - begin) * sizeof(std::complex< double >));
+    });
+}
+
+std::vector< std::vector< int > > StateBuffer::nodeCpus()
+{
+    std::vector< std::vector< int > > res;
+    for (int node = 0; ; ++node) {
+	std::stringstream path;
+	path << "/sys/devices/system/node/node" << node << "/cpulist";
+	std::ifstream file(path.str().c_str());
+	if (!file) break;
+	std::string list;
+	std::getline(file, list);
+	res.push_back(parseCpuList(list));
+    }
+    if (res.empty() || res[0].empty()) {
+	res.assign(1, std::vector< int >());
+	for (int cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu)
+	    res[0].push_back(cpu);
+    }
+    return res;
+}
+
+#ifndef Performing
+
+void StateBuffer::parallelFor(const std::function< void (int, long long, long long) >& body) const
+{
+    std::vector< std::thread > workers;
+    for (int t = 0; t < threadsCount(); ++t)
+	workers.push_back(std::thread([this, t, &body]() {
+	    pinToCpus(_nodeCpus[_threadNodes[t]]);
+	    body(t, _ranges[t], _ranges[t + 1]);
+	}));
+    for (int t = 0; t < workers.size(); ++t)
+	workers[t].join();
+}
+
+void StateBuffer::apply(const MatrixXcd& op, const std::vector< int >& subsystems, const std::vector< uint >& dimensions)
+{
+    long long total = 1;
+    for (int i = 0; i < dimensions.size(); ++i)
+	total *= dimensions[i];
+    if (total != _size)
+	throw std::invalid_argument("Buffer size does not match space dimension");
+    // checked here, exceptions must not be thrown in workers
+    long long localDim = KroneckerTensor::localDimension(subsystems, dimensions);
+    if (op.rows() != localDim || op.cols() != localDim)
+	throw std::invalid_argument("Operator size does not match subsystems dimensions");
+    
+    // ranges are scaled to the groups of amplitudes, so a worker writes only its own range unless the group spans
+    // more than the range (gate on leading subsystems); then every worker still gets an equal share of groups
+    std::complex< double >* data = _data;
+    parallelFor([&](int, long long begin, long long end) {
+	KroneckerTensor::applyToSubsystems(op, subsystems, dimensions, data, begin / localDim, end / localDim);
+    });
+}
+
+#endif
+
+#ifndef Getters
+
+std::complex< double >* StateBuffer::data()
+{
+    return _data;
+}
+
+const std::complex< double >* StateBuffer::data() const
+{
+    return _data;
+}
+
+long long StateBuffer::size() const
+{
+    return _size;
+}
+
+Map< VectorXcd > StateBuffer::vector()
+{
+    return Map< VectorXcd >(_data, _size);
+}
+
+int StateBuffer::threadsCount() const
+{
+    return _threadNodes.size();
+}
+
+int StateBuffer::nodesCount() const
+{
+    return _nodeCpus.size();
+}
+
+int StateBuffer::nodeOf(int thread) const
+{
+    return _threadNodes.at(thread);
+}
+
+std::vector< long long > StateBuffer::ranges() const
+{
+    return _ranges;
+}
+
+#endif
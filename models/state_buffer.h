@@ -0,0 +1,111 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef STATE_BUFFER_H
+#define STATE_BUFFER_H
+
+#include "../Eigen/Core"
+#include <complex>
+#include <functional>
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * Storage of large state vector aware of NUMA nodes. Amplitudes are split into contiguous ranges, one per worker thread;
+ * every worker is pinned to CPUs of its node and touches its range first, so pages of the range are placed on that
+ * node. The same workers later update the same ranges, see parallelFor() and apply()
+ */
+class StateBuffer
+{
+public:
+    enum Placement {
+	FirstTouch, // pages go where pinned worker touches them first
+	Partition, // range of every worker is also bound to its node
+	Interleave // pages are spread over all nodes round-robin
+    };
+    
+    /**
+     * Allocate buffer filled with zeros
+     * @param size Count of amplitudes
+     * @param placement How pages are placed on nodes
+     * @param threads Count of workers, 0 means hardware concurrency
+     * @param hugePages Ask kernel for transparent huge pages
+     */
+    StateBuffer(long long size, Placement placement = Partition, int threads = 0, bool hugePages = true);
+    ~StateBuffer();
+    
+    std::complex< double >* data();
+    const std::complex< double >* data() const;
+    long long size() const;
+    
+    /**
+     * Map of the buffer as Eigen vector
+     */
+    Map< VectorXcd > vector();
+    
+    int threadsCount() const;
+    int nodesCount() const;
+    int nodeOf(int thread) const;
+    
+    /**
+     * First index of range of every worker and size() at the end
+     */
+    std::vector< long long > ranges() const;
+    
+    /**
+     * Run body in every pinned worker for its own range and wait for all of them
+     * @param body Called as body(thread, begin, end)
+     */
+    void parallelFor(const std::function< void (int, long long, long long) >& body) const;
+    
+    /**
+     * Apply operator to subsystems of the vector, groups of amplitudes are shared between workers in proportion to
+     * their ranges, so each worker updates amplitudes of its range when the subsystems are not the leading ones.
+     * See KroneckerTensor::applyToSubsystems()
+     */
+    void apply(const MatrixXcd& op, const std::vector< int >& subsystems, const std::vector< uint >& dimensions);
+    
+    /**
+     * CPUs of every NUMA node as listed in /sys/devices/system/node; one node with all CPUs if there is no such list
+     */
+    static std::vector< std::vector< int > > nodeCpus();
+    
+private:
+    std::complex< double >* _data;
+    long long _size;
+    size_t _bytes;
+    std::vector< std::vector< int > > _nodeCpus;
+    std::vector< long long > _ranges;
+    std::vector< int > _threadNodes;
+    
+    void _place(Placement placement);
+    
+    StateBuffer(const StateBuffer&);
+    StateBuffer& operator=(const StateBuffer&);
+};
+
+#endif // STATE_BUFFER_H
@@ -0,0 +1,128 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "state_metrics.h"
+#include "schmidt_decomposition.h"
+#include "../Eigen/Eigenvalues"
+#include <stdexcept>
+
+#ifndef Entropy
+
+double StateMetrics::purity(const QuantumState& state)
+{
+    return state.purity();
+}
+
+double StateMetrics::vonNeumannEntropy(const QuantumState& state)
+{
+    VectorXd values = state.eigenValues();
+    double res = 0;
+    for (int i = 0; i < values.size(); ++i)
+	if (values[i] > 1.0e-15) // 0 * log(0) = 0
+	    res -= values[i] * log2(values[i]);
+    return res;
+}
+
+double StateMetrics::renyi2Entropy(const QuantumState& state)
+{
+    return -log2(state.purity());
+}
+
+double StateMetrics::entanglementEntropy(const VectorXcd& vec, const HilbertSpace& space, const std::vector< int >& subsystemsA)
+{
+    return SchmidtDecomposition(vec, space, subsystemsA).entropy();
+}
+
+double StateMetrics::entanglementEntropy(const QuantumState& state, const std::vector< int >& subsystemsA)
+{
+    return SchmidtDecomposition(state, subsystemsA).entropy();
+}
+
+#endif
+
+#ifndef Distances
+
+void StateMetrics::_checkSizes(int first, int second)
+{
+    if (first != second)
+	throw std::invalid_argument("States must have the same dimension");
+}
+
+double StateMetrics::fidelity(const QuantumState& first, const QuantumState& second)
+{
+    const MatrixXcd& p = first.densityMatrix();
+    const MatrixXcd& s = second.densityMatrix();
+    _checkSizes(p.rows(), s.rows());
+    if (first.isPure() || second.isPure()) // F = <psi|s|psi> = Tr(p * s)
+	return p.cwiseProduct(s.transpose()).sum().real();
+    
+    // sqrt(p) from cached spectrum, negative rounding errors are cut off
+    VectorXd values = first.eigenValues();
+    MatrixXcd vectors = first.eigenVectors();
+    VectorXcd roots = values.cwiseMax(0).cwiseSqrt().cast< std::complex< double > >();
+    MatrixXcd root = vectors * roots.asDiagonal() * vectors.adjoint();
+    
+    SelfAdjointEigenSolver<MatrixXcd> solver(root * s * root, EigenvaluesOnly);
+    double res = solver.eigenvalues().cwiseMax(0).cwiseSqrt().sum();
+    return res * res;
+}
+
+double StateMetrics::fidelity(const VectorXcd& first, const QuantumState& second)
+{
+    _checkSizes(first.size(), second.densityMatrix().rows());
+    return (first.adjoint() * second.densityMatrix() * first)(0, 0).real() / first.squaredNorm();
+}
+
+double StateMetrics::fidelity(const VectorXcd& first, const VectorXcd& second)
+{
+    _checkSizes(first.size(), second.size());
+    return std::norm(first.dot(second)) / (first.squaredNorm() * second.squaredNorm());
+}
+
+double StateMetrics::traceDistance(const QuantumState& first, const QuantumState& second)
+{
+    _checkSizes(first.densityMatrix().rows(), second.densityMatrix().rows());
+    SelfAdjointEigenSolver<MatrixXcd> solver(first.densityMatrix() - second.densityMatrix(), EigenvaluesOnly);
+    return solver.eigenvalues().cwiseAbs().sum() / 2;
+}
+
+double StateMetrics::traceDistance(const VectorXcd& first, const QuantumState& second)
+{
+    _checkSizes(first.size(), second.densityMatrix().rows());
+    if (second.isPure()) // for two pure states D = sqrt(1 - F)
+	return sqrt(std::max(0.0, 1 - fidelity(first, second)));
+    
+    MatrixXcd difference = first * first.adjoint() / first.squaredNorm() - second.densityMatrix();
+    SelfAdjointEigenSolver<MatrixXcd> solver(difference, EigenvaluesOnly);
+    return solver.eigenvalues().cwiseAbs().sum() / 2;
+}
+
+double StateMetrics::traceDistance(const VectorXcd& first, const VectorXcd& second)
+{
+    return sqrt(std::max(0.0, 1 - fidelity(first, second)));
+}
+
+#endif
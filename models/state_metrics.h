@@ -0,0 +1,96 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef STATE_METRICS_H
+#define STATE_METRICS_H
+
+#include "../Eigen/Core"
+#include "quantum_state.h"
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * Scalar characteristics of quantum states. Everything that can avoid eigen decomposition does so;
+ * the rest reuses spectrum cached inside QuantumState. Entropies are in bits.
+ * Overloads taking state vectors are shortcuts for pure states
+ */
+class StateMetrics
+{
+public:
+    /**
+     * Returns Tr(p^2) in O(N^2)
+     */
+    static double purity(const QuantumState& state);
+    
+    /**
+     * Returns -Tr(p * log2(p)) computed from cached eigen values
+     */
+    static double vonNeumannEntropy(const QuantumState& state);
+    
+    /**
+     * Returns -log2(Tr(p^2)) in O(N^2)
+     */
+    static double renyi2Entropy(const QuantumState& state);
+    
+    /**
+     * Returns fidelity (Tr(sqrt(sqrt(p) * s * sqrt(p))))^2. If one of the states is pure it is just Tr(p * s)
+     */
+    static double fidelity(const QuantumState& first, const QuantumState& second);
+    
+    /**
+     * Returns <psi|s|psi> in O(N^2)
+     */
+    static double fidelity(const VectorXcd& first, const QuantumState& second);
+    
+    /**
+     * Returns |<psi|phi>|^2 in O(N)
+     */
+    static double fidelity(const VectorXcd& first, const VectorXcd& second);
+    
+    /**
+     * Returns 1/2 * Tr|p - s|
+     */
+    static double traceDistance(const QuantumState& first, const QuantumState& second);
+    static double traceDistance(const VectorXcd& first, const QuantumState& second);
+    
+    /**
+     * Returns sqrt(1 - |<psi|phi>|^2) in O(N)
+     */
+    static double traceDistance(const VectorXcd& first, const VectorXcd& second);
+    
+    /**
+     * Returns entropy of entanglement between listed subsystems and the rest of pure state, in bits.
+     * Computed via Schmidt decomposition, no reduced density matrix is constructed
+     */
+    static double entanglementEntropy(const VectorXcd& vec, const HilbertSpace& space, const std::vector< int >& subsystemsA);
+    static double entanglementEntropy(const QuantumState& state, const std::vector< int >& subsystemsA);
+    
+private:
+    static void _checkSizes(int first, int second);
+};
+
+#endif // STATE_METRICS_H
@@ -0,0 +1,410 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "tensor_network.h"
+#include "kronecker_tensor.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <stdexcept>
+
+TensorNetwork::TensorNetwork()
+{
+}
+
+int TensorNetwork::newIndex(uint dimension)
+{
+    _indexDimensions.push_back(dimension);
+    return _indexDimensions.size() - 1;
+}
+
+int TensorNetwork::addTensor(const VectorXcd& data, const std::vector< int >& indices)
+{
+    NetworkTensor t;
+    t.indices = indices;
+    for (int i = 0; i < indices.size(); ++i) {
+	if (indices[i] < 0 || indices[i] >= _indexDimensions.size())
+	    throw std::invalid_argument("Index is not created by this network");
+	t.dimensions.push_back(_indexDimensions[indices[i]]);
+    }
+    if (data.size() != _size(indices))
+	throw std::invalid_argument("Data size does not match dimensions of indices");
+    t.data = data;
+    _tensors.push_back(t);
+    return _tensors.size() - 1;
+}
+
+int TensorNetwork::tensorsCount() const
+{
+    return _tensors.size();
+}
+
+const NetworkTensor& TensorNetwork::tensor(int index) const
+{
+    return _tensors.at(index);
+}
+
+double TensorNetwork::_size(const std::vector< int >& indices) const
+{
+    double size = 1;
+    for (int i = 0; i < indices.size(); ++i)
+	size *= _indexDimensions[indices[i]];
+    return size;
+}
+
+namespace {
+// indices of a not shared with b, then indices of b not shared with a
+std::vector< int > freeIndices(const std::vector< int >& a, const std::vector< int >& b)
+{
+    std::vector< int > res;
+    for (int i = 0; i < a.size(); ++i)
+	if (std::find(b.begin(), b.end(), a[i]) == b.end())
+	    res.push_back(a[i]);
+    for (int i = 0; i < b.size(); ++i)
+	if (std::find(a.begin(), a.end(), b[i]) == a.end())
+	    res.push_back(b[i]);
+    return res;
+}
+}
+
+#ifndef Ordering
+
+ContractionPath TensorNetwork::_randomizedGreedy(RandomGenerator* generator) const
+{
+    std::vector< std::vector< int > > live;
+    std::vector< bool > alive(_tensors.size(), true);
+    std::vector< std::vector< int > > owners(_indexDimensions.size());
+    for (int t = 0; t < _tensors.size(); ++t) {
+	live.push_back(_tensors[t].indices);
+	for (int i = 0; i < _tensors[t].indices.size(); ++i)
+	    owners[_tensors[t].indices[i]].push_back(t);
+    }
+    
+    ContractionPath path;
+    for (int count = _tensors.size(); count > 1; --count) {
+	std::set< std::pair< int, int > > pairs;
+	for (int i = 0; i < owners.size(); ++i)
+	    if (owners[i].size() == 2)
+		pairs.insert(std::make_pair(std::min(owners[i][0], owners[i][1]), std::max(owners[i][0], owners[i][1])));
+	
+	std::pair< int, int > chosen;
+	if (pairs.empty()) {
+	    // disconnected parts are joined by outer product of the two smallest tensors
+	    std::vector< std::pair< double, int > > sizes;
+	    for (int t = 0; t < live.size(); ++t)
+		if (alive[t])
+		    sizes.push_back(std::make_pair(_size(live[t]), t));
+	    std::sort(sizes.begin(), sizes.end());
+	    chosen = std::make_pair(sizes[0].second, sizes[1].second);
+	}
+	else {
+	    // score is growth of memory: size of result minus sizes of contracted tensors
+	    std::vector< std::pair< int, int > > candidates(pairs.begin(), pairs.end());
+	    std::vector< double > scores(candidates.size());
+	    double best = std::numeric_limits< double >::max();
+	    int bestNum = 0;
+	    for (int c = 0; c < candidates.size(); ++c) {
+		const std::vector< int >& a = live[candidates[c].first];
+		const std::vector< int >& b = live[candidates[c].second];
+		scores[c] = _size(freeIndices(a, b)) - _size(a) - _size(b);
+		if (scores[c] < best) {
+		    best = scores[c];
+		    bestNum = c;
+		}
+	    }
+	    if (generator != 0) {
+		double temperature = std::max(1.0, std::abs(best)), total = 0;
+		std::vector< double > weights(candidates.size());
+		for (int c = 0; c < candidates.size(); ++c)
+		    total += weights[c] = std::exp(-(scores[c] - best) / temperature);
+		double point = generator->uniform() * total;
+		for (bestNum = 0; bestNum < (int) candidates.size() - 1 && point >= weights[bestNum]; ++bestNum)
+		    point -= weights[bestNum];
+	    }
+	    chosen = candidates[bestNum];
+	}
+	
+	int result = live.size();
+	std::vector< int > indices = freeIndices(live[chosen.first], live[chosen.second]);
+	for (int side = 0; side < 2; ++side) {
+	    const std::vector< int >& old = live[side == 0 ? chosen.first : chosen.second];
+	    for (int i = 0; i < old.size(); ++i) {
+		std::vector< int >& own = owners[old[i]];
+		own.erase(std::remove(own.begin(), own.end(), side == 0 ? chosen.first : chosen.second), own.end());
+	    }
+	}
+	for (int i = 0; i < indices.size(); ++i)
+	    owners[indices[i]].push_back(result);
+	alive[chosen.first] = alive[chosen.second] = false;
+	live.push_back(indices);
+	alive.push_back(true);
+	path.steps.push_back(chosen);
+    }
+    estimateCosts(path);
+    return path;
+}
+
+ContractionPath TensorNetwork::optimizeOrder(int trials, uint64_t seed, double maxPeakSize) const
+{
+    RandomGenerator generator(seed);
+    ContractionPath best = _randomizedGreedy(0);
+    for (int trial = 1; trial < trials; ++trial) {
+	ContractionPath path = _randomizedGreedy(&generator);
+	bool fits = maxPeakSize <= 0 || path.peakSize <= maxPeakSize;
+	bool bestFits = maxPeakSize <= 0 || best.peakSize <= maxPeakSize;
+	if (fits ? (!bestFits || path.flops < best.flops) : (!bestFits && path.peakSize < best.peakSize))
+	    best = path;
+    }
+    return best;
+}
+
+void TensorNetwork::estimateCosts(ContractionPath& path) const
+{
+    std::vector< std::vector< int > > live;
+    double total = 0;
+    for (int t = 0; t < _tensors.size(); ++t) {
+	live.push_back(_tensors[t].indices);
+	total += _size(_tensors[t].indices);
+    }
+    path.flops = 0;
+    path.peakSize = total;
+    for (int s = 0; s < path.steps.size(); ++s) {
+	const std::vector< int >& a = live.at(path.steps[s].first);
+	const std::vector< int >& b = live.at(path.steps[s].second);
+	std::vector< int > all = a;
+	for (int i = 0; i < b.size(); ++i)
+	    if (std::find(a.begin(), a.end(), b[i]) == a.end())
+		all.push_back(b[i]);
+	std::vector< int > result = freeIndices(a, b);
+	path.flops += _size(all);
+	total += _size(result);
+	path.peakSize = std::max(path.peakSize, total);
+	total -= _size(a) + _size(b);
+	live.push_back(result);
+    }
+}
+
+#endif
+
+#ifndef Contracting
+
+NetworkTensor TensorNetwork::permuted(const NetworkTensor& t, const std::vector< int >& indices)
+{
+    if (indices.size() != t.indices.size())
+	throw std::invalid_argument("Indices do not match indices of tensor");
+    std::vector< int > perm(indices.size());
+    NetworkTensor res;
+    res.indices = indices;
+    for (int i = 0; i < indices.size(); ++i) {
+	std::vector< int >::const_iterator it = std::find(t.indices.begin(), t.indices.end(), indices[i]);
+	if (it == t.indices.end())
+	    throw std::invalid_argument("Indices do not match indices of tensor");
+	perm[i] = it - t.indices.begin();
+	res.dimensions.push_back(t.dimensions[perm[i]]);
+    }
+    MatrixXcd data = t.data;
+    KroneckerTensor::permuteSubsystems(perm, t.dimensions, data);
+    res.data = data.col(0);
+    return res;
+}
+
+NetworkTensor TensorNetwork::contractPair(const NetworkTensor& a, const NetworkTensor& b)
+{
+    std::vector< int > freeA, freeB, shared;
+    for (int i = 0; i < a.indices.size(); ++i)
+	if (std::find(b.indices.begin(), b.indices.end(), a.indices[i]) == b.indices.end())
+	    freeA.push_back(a.indices[i]);
+	else shared.push_back(a.indices[i]);
+    for (int i = 0; i < b.indices.size(); ++i)
+	if (std::find(a.indices.begin(), a.indices.end(), b.indices[i]) == a.indices.end())
+	    freeB.push_back(b.indices[i]);
+    
+    // a as (free, shared) and b as (shared, free) flat row-major arrays are column-major a^T and b^T,
+    // so result^T = b^T * a^T is one matrix product
+    std::vector< int > orderA = freeA, orderB = shared;
+    orderA.insert(orderA.end(), shared.begin(), shared.end());
+    orderB.insert(orderB.end(), freeB.begin(), freeB.end());
+    NetworkTensor pa = permuted(a, orderA), pb = permuted(b, orderB);
+    
+    int sharedSize = 1;
+    for (int i = freeA.size(); i < pa.dimensions.size(); ++i)
+	sharedSize *= pa.dimensions[i];
+    int sizeA = pa.data.size() / sharedSize, sizeB = pb.data.size() / sharedSize;
+    Map< MatrixXcd > ma(pa.data.data(), sharedSize, sizeA), mb(pb.data.data(), sizeB, sharedSize);
+    MatrixXcd product = mb * ma;
+    
+    NetworkTensor res;
+    res.indices = freeA;
+    res.indices.insert(res.indices.end(), freeB.begin(), freeB.end());
+    res.dimensions.assign(pa.dimensions.begin(), pa.dimensions.begin() + freeA.size());
+    res.dimensions.insert(res.dimensions.end(), pb.dimensions.begin() + shared.size(), pb.dimensions.end());
+    res.data = Map< VectorXcd >(product.data(), product.size());
+    return res;
+}
+
+NetworkTensor TensorNetwork::contract(const ContractionPath& path, const std::vector< int >& openIndices) const
+{
+    if (_tensors.empty())
+	throw std::runtime_error("Network is empty");
+    std::vector< NetworkTensor > live = _tensors;
+    std::vector< bool > alive(live.size(), true);
+    for (int s = 0; s < path.steps.size(); ++s) {
+	int a = path.steps[s].first, b = path.steps[s].second;
+	if (a >= live.size() || b >= live.size() || !alive[a] || !alive[b] || a == b)
+	    throw std::invalid_argument("Path uses tensor that is not alive");
+	live.push_back(contractPair(live[a], live[b]));
+	alive.push_back(true);
+	alive[a] = alive[b] = false;
+	live[a].data.resize(0); // free memory as soon as possible
+	live[b].data.resize(0);
+    }
+    
+    // path may leave several tensors, they are joined in order
+    int res = -1;
+    for (int t = 0; t < live.size(); ++t) {
+	if (!alive[t]) continue;
+	if (res < 0) res = t;
+	else {
+	    live[res] = contractPair(live[res], live[t]);
+	    live[t].data.resize(0);
+	}
+    }
+    return permuted(live[res], openIndices);
+}
+
+NetworkTensor TensorNetwork::contract(const std::vector< int >& openIndices) const
+{
+    return contract(optimizeOrder(), openIndices);
+}
+
+#endif
+
+#ifndef Circuits
+
+int TensorNetwork::_addGate(TensorNetwork& network, const MatrixXcd& matrix, std::vector< int >& wires, const std::vector< int >& subsystems)
+{
+    // gate tensor has indices (outputs..., inputs...), so its flat data is the matrix in row-major order
+    std::vector< int > indices(subsystems.size() * 2);
+    for (int i = 0; i < subsystems.size(); ++i) {
+	indices[subsystems.size() + i] = wires[subsystems[i]];
+	indices[i] = wires[subsystems[i]] = network.newIndex(network._indexDimensions[wires[subsystems[i]]]);
+    }
+    VectorXcd data(matrix.size());
+    for (int row = 0; row < matrix.rows(); ++row)
+	data.segment(row * matrix.cols(), matrix.cols()) = matrix.row(row).transpose();
+    return network.addTensor(data, indices);
+}
+
+int TensorNetwork::_addBasisVector(TensorNetwork& network, uint dimension, int digit, int wire)
+{
+    if (digit < 0 || digit >= dimension)
+	throw std::invalid_argument("Digit is out of subsystem dimension");
+    VectorXcd data = VectorXcd::Zero(dimension);
+    data[digit] = 1;
+    return network.addTensor(data, std::vector< int >(1, wire));
+}
+
+VectorXcd TensorNetwork::amplitudes(const Circuit& circuit, const std::vector< int >& outcome, const std::vector< int >& openSubsystems)
+{
+    const std::vector< uint >& dims = circuit.dimensions();
+    if (outcome.size() != circuit.rank())
+	throw std::invalid_argument("Outcome must have digit for every subsystem");
+    
+    TensorNetwork network;
+    std::vector< int > wires(circuit.rank());
+    for (int s = 0; s < circuit.rank(); ++s) {
+	wires[s] = network.newIndex(dims[s]);
+	_addBasisVector(network, dims[s], 0, wires[s]);
+    }
+    for (int g = 0; g < circuit.gatesCount(); ++g)
+	_addGate(network, circuit.gate(g).matrix, wires, circuit.gate(g).subsystems);
+    
+    std::vector< bool > open(circuit.rank(), false);
+    std::vector< int > openIndices;
+    for (int i = 0; i < openSubsystems.size(); ++i) {
+	if (openSubsystems[i] < 0 || openSubsystems[i] >= circuit.rank() || open[openSubsystems[i]])
+	    throw std::invalid_argument("Wrong list of open subsystems");
+	open[openSubsystems[i]] = true;
+	openIndices.push_back(wires[openSubsystems[i]]);
+    }
+    for (int s = 0; s < circuit.rank(); ++s)
+	if (!open[s])
+	    _addBasisVector(network, dims[s], outcome[s], wires[s]);
+    return network.contract(openIndices).data;
+}
+
+std::complex< double > TensorNetwork::amplitude(const Circuit& circuit, const std::vector< int >& outcome)
+{
+    return amplitudes(circuit, outcome, std::vector< int >())[0];
+}
+
+std::complex< double > TensorNetwork::expectation(const Circuit& circuit, const MatrixXcd& op, const std::vector< int >& subsystems)
+{
+    const std::vector< uint >& dims = circuit.dimensions();
+    std::vector< bool > active(circuit.rank(), false);
+    int opSize = 1;
+    for (int i = 0; i < subsystems.size(); ++i) {
+	if (subsystems[i] < 0 || subsystems[i] >= circuit.rank() || active[subsystems[i]])
+	    throw std::invalid_argument("Wrong list of operator subsystems");
+	active[subsystems[i]] = true;
+	opSize *= dims[subsystems[i]];
+    }
+    if (op.rows() != opSize || op.cols() != opSize)
+	throw std::invalid_argument("Operator size does not match subsystems dimensions");
+    
+    // walk gates backwards: gate touching light cone joins it, other gates cancel in U^+ U
+    std::vector< bool > kept(circuit.gatesCount(), false);
+    for (int g = circuit.gatesCount() - 1; g >= 0; --g) {
+	const std::vector< int >& subs = circuit.gate(g).subsystems;
+	for (int i = 0; i < subs.size() && !kept[g]; ++i)
+	    kept[g] = active[subs[i]];
+	if (kept[g])
+	    for (int i = 0; i < subs.size(); ++i)
+		active[subs[i]] = true;
+    }
+    
+    TensorNetwork network;
+    std::vector< int > wires(circuit.rank(), -1);
+    for (int s = 0; s < circuit.rank(); ++s)
+	if (active[s]) {
+	    wires[s] = network.newIndex(dims[s]);
+	    _addBasisVector(network, dims[s], 0, wires[s]);
+	}
+    for (int g = 0; g < circuit.gatesCount(); ++g)
+	if (kept[g])
+	    _addGate(network, circuit.gate(g).matrix, wires, circuit.gate(g).subsystems);
+    _addGate(network, op, wires, subsystems);
+    for (int g = circuit.gatesCount() - 1; g >= 0; --g)
+	if (kept[g])
+	    _addGate(network, circuit.gate(g).matrix.adjoint(), wires, circuit.gate(g).subsystems);
+    for (int s = 0; s < circuit.rank(); ++s)
+	if (active[s])
+	    _addBasisVector(network, dims[s], 0, wires[s]);
+    return network.contract(std::vector< int >()).data[0];
+}
+
+#endif
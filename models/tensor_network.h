@@ -0,0 +1,149 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef TENSOR_NETWORK_H
+#define TENSOR_NETWORK_H
+
+#include "../Eigen/Core"
+#include "circuit.h"
+#include "random_generator.h"
+#include <complex>
+#include <vector>
+#include <stdint.h>
+
+using namespace Eigen;
+
+/**
+ * Tensor with named indices. Data is stored flat, the first index is the most significant (as subsystems of states)
+ */
+struct NetworkTensor
+{
+    std::vector< int > indices;
+    std::vector< uint > dimensions;
+    VectorXcd data;
+};
+
+/**
+ * Order of pairwise contractions. Tensors are numbered as added to network, result of step k gets number
+ * (tensors count + k). Costs are estimated before contraction
+ */
+struct ContractionPath
+{
+    std::vector< std::pair< int, int > > steps;
+    double flops; // count of complex multiply-adds
+    double peakSize; // max count of elements of all tensors alive at once
+};
+
+/**
+ * Tensor network: every index is shared by at most two tensors, indices owned by one tensor stay open in the result.
+ * Pair of tensors is contracted as one matrix product after putting shared indices together with
+ * KroneckerTensor::permuteSubsystems().
+ * Static helpers turn circuit applied to |0...0> into network, so that amplitudes and local expectations of wide
+ * shallow circuits can be found without storing full state
+ */
+class TensorNetwork
+{
+public:
+    TensorNetwork();
+    
+    /**
+     * Returns new index that is not used yet
+     */
+    int newIndex(uint dimension);
+    
+    /**
+     * Add tensor
+     * @param data Flat data of size equal to product of index dimensions
+     * @param indices Indices created by newIndex(), each may be used by two tensors at most
+     * @return Number of tensor
+     */
+    int addTensor(const VectorXcd& data, const std::vector< int >& indices);
+    
+    int tensorsCount() const;
+    const NetworkTensor& tensor(int index) const;
+    
+    /**
+     * Find contraction order: the first trial is pure greedy (pair whose result grows memory the least), other trials
+     * choose pairs randomly with Boltzmann weights of the same score. The path with least flops whose peak size fits
+     * the limit wins; if no path fits, the one with least peak size is returned
+     * @param trials Count of trials including the greedy one
+     * @param seed Seed of random choice, see RandomGenerator
+     * @param maxPeakSize Limit of peak size, 0 means no limit
+     */
+    ContractionPath optimizeOrder(int trials = 32, uint64_t seed = 0, double maxPeakSize = 0) const;
+    
+    /**
+     * Estimate costs of given steps, fills flops and peakSize
+     */
+    void estimateCosts(ContractionPath& path) const;
+    
+    /**
+     * Contract network along the path. Open indices of result are ordered as in openIndices
+     */
+    NetworkTensor contract(const ContractionPath& path, const std::vector< int >& openIndices) const;
+    NetworkTensor contract(const std::vector< int >& openIndices) const;
+    
+    /**
+     * Contract two tensors over their shared indices; result indices are free ones of a, then of b
+     */
+    static NetworkTensor contractPair(const NetworkTensor& a, const NetworkTensor& b);
+    
+    /**
+     * Reorder indices of tensor, see KroneckerTensor::permuteSubsystems()
+     */
+    static NetworkTensor permuted(const NetworkTensor& t, const std::vector< int >& indices);
+    
+    /**
+     * Amplitude <outcome| C |0...0>
+     * @param outcome Basis state digit for every subsystem
+     */
+    static std::complex< double > amplitude(const Circuit& circuit, const std::vector< int >& outcome);
+    
+    /**
+     * Amplitudes of all basis states of open subsystems, other subsystems are fixed by outcome
+     * @param outcome Basis state digit for every subsystem, digits of open subsystems are ignored
+     * @param openSubsystems Subsystems left open, the first one is the most significant in the result
+     */
+    static VectorXcd amplitudes(const Circuit& circuit, const std::vector< int >& outcome, const std::vector< int >& openSubsystems);
+    
+    /**
+     * Expectation <0...0| C^+ O C |0...0> of local operator. Gates outside of backward light cone of the operator
+     * cancel with their adjoints and are not added to network
+     * @param op Operator acting on listed subsystems, the first one is the most significant
+     */
+    static std::complex< double > expectation(const Circuit& circuit, const MatrixXcd& op, const std::vector< int >& subsystems);
+    
+private:
+    std::vector< NetworkTensor > _tensors;
+    std::vector< uint > _indexDimensions;
+    
+    ContractionPath _randomizedGreedy(RandomGenerator* generator) const;
+    double _size(const std::vector< int >& indices) const;
+    static int _addGate(TensorNetwork& network, const MatrixXcd& matrix, std::vector< int >& wires, const std::vector< int >& subsystems);
+    static int _addBasisVector(TensorNetwork& network, uint dimension, int digit, int wire);
+};
+
+#endif // TENSOR_NETWORK_H
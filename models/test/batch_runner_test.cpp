@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "../batch_runner.h"
+#include "../work_stealing.h"
+#include <atomic>
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+
+namespace {
+std::vector<BatchJob> sweep(int count)
+{
+    std::vector<BatchJob> jobs;
+    HilbertSpace space(std::vector<uint>(3, 2));
+    QuantumState zero(VectorXcd::Unit(8, 0), space);
+    std::vector<int> pair; pair.push_back(0); pair.push_back(2);
+    for (int i = 0; i < count; ++i) {
+	Circuit circuit(space);
+	circuit.addGate(HadamardGate(), 0);
+	circuit.addGate(PhaseShiftGate(0.1 * i), 0);
+	circuit.addGate(HadamardGate(), 0);
+	circuit.addGate(CNOTGate(), pair);
+	jobs.push_back(BatchJob(circuit, zero, 1000, pair));
+    }
+    return jobs;
+}
+}
+
+TEST(BatchRunnerTest, TestSweepResults) {
+    std::vector<BatchJob> jobs = sweep(20);
+    BatchRunner runner(4, 7);
+    std::vector<BatchResult> results = runner.run(jobs);
+    ASSERT_EQ(20, results.size());
+    for (int i = 0; i < 20; ++i) {
+	// H P(phi) H |0> = cos(phi/2) |0> + ... , CNOT copies it to qubit 2
+	double p0 = pow(cos(0.05 * i), 2);
+	EXPECT_EQ(4, results[i].probabilities.size());
+	EXPECT_EQ(true, abs(results[i].probabilities[0] - p0) < 1.0e-12);
+	EXPECT_EQ(true, abs(results[i].probabilities[3] - (1 - p0)) < 1.0e-12);
+	EXPECT_EQ(1000, results[i].counts[0] + results[i].counts[3]);
+	EXPECT_EQ(true, abs(results[i].counts[0] / 1000.0 - p0) < 0.06);
+    }
+    std::vector<int> perWorker = runner.jobsPerWorker();
+    int total = 0;
+    for (int w = 0; w < perWorker.size(); ++w) total += perWorker[w];
+    EXPECT_EQ(20, total);
+}
+
+TEST(BatchRunnerTest, TestResultsDoNotDependOnThreads) {
+    std::vector<BatchJob> jobs = sweep(12);
+    std::vector<BatchResult> single = BatchRunner(1, 3).run(jobs), parallel = BatchRunner(5, 3).run(jobs);
+    for (int i = 0; i < 12; ++i)
+	EXPECT_EQ(single[i].counts, parallel[i].counts);
+    EXPECT_NE(single[11].counts, BatchRunner(5, 4).run(jobs)[11].counts);
+}
+
+TEST(BatchRunnerTest, TestExceptionInTaskIsRethrown) {
+    // every worker throws on its first task; the pool still joins all threads and gives the error to the caller
+    std::atomic<int> started(0);
+    EXPECT_THROW(runWorkStealing(8, 4, [&](int, int) {
+	++started;
+	throw std::runtime_error("task failed");
+    }), std::runtime_error);
+    EXPECT_EQ(true, started.load() >= 1 && started.load() <= 4);
+    
+    std::atomic<int> done(0);
+    EXPECT_THROW(runWorkStealing(8, 4, [&](int, int task) {
+	if (task == 5) throw std::invalid_argument("bad task");
+	++done;
+    }), std::invalid_argument);
+    EXPECT_EQ(true, done.load() <= 7);
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "../ensemble_state.h"
+#include "../kronecker_tensor.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/pauligate.h"
+
+TEST(EnsembleStateTest, TestGatesAndChannelMatchDensity) {
+    std::vector<uint> dims(3, 2);
+    HilbertSpace space(dims);
+    std::vector<int> pair; pair.push_back(0); pair.push_back(1);
+    VectorXcd vec = VectorXcd::Zero(8);
+    vec[0] = 1;
+    
+    EnsembleState state(vec, space);
+    state.apply(HadamardGate().transformMatrix(), std::vector<int>(1, 0));
+    state.apply(CNOTGate().transformMatrix(), pair);
+    // dephasing of qubit 2 after Hadamard: rank 2
+    std::vector<MatrixXcd> kraus;
+    kraus.push_back(sqrt(0.7) * MatrixXcd::Identity(2, 2));
+    kraus.push_back(sqrt(0.3) * PauliGate(PauliGate::Z).transformMatrix());
+    state.apply(HadamardGate().transformMatrix(), std::vector<int>(1, 2));
+    state.applyChannel(kraus, std::vector<int>(1, 2));
+    EXPECT_EQ(2, state.rank());
+    
+    MatrixXcd density = vec * vec.adjoint();
+    MatrixXcd h0 = KroneckerTensor::expand(HadamardGate().transformMatrix(), 0, dims);
+    MatrixXcd h2 = KroneckerTensor::expand(HadamardGate().transformMatrix(), 2, dims);
+    MatrixXcd z2 = KroneckerTensor::expand(PauliGate(PauliGate::Z).transformMatrix(), 2, dims);
+    MatrixXcd cnot = KroneckerTensor::product(CNOTGate().transformMatrix(), KroneckerTensor::getIdentityMatrix(2));
+    density = h2 * cnot * h0 * density * h0.adjoint() * cnot.adjoint() * h2.adjoint();
+    density = 0.7 * density + 0.3 * z2 * density * z2;
+    EXPECT_EQ(true, state.densityMatrix().isApprox(density));
+    EXPECT_EQ(true, state.probabilities().isApprox(density.diagonal().real()));
+    EXPECT_EQ(true, abs(state.purity() - (density * density).trace().real()) < 1.0e-12);
+    EXPECT_EQ(true, abs(state.expectation(PauliGate(PauliGate::X).transformMatrix(), std::vector<int>(1, 2)) - 0.4) < 1.0e-12);
+    
+    // the same state built from density matrix has the same rank
+    EnsembleState fromDensity(QuantumState(density, space));
+    EXPECT_EQ(2, fromDensity.rank());
+    EXPECT_EQ(fromDensity.toQuantumState(), state.toQuantumState());
+}
+
+TEST(EnsembleStateTest, TestTruncateAndMeasure) {
+    std::vector<uint> dims; dims.push_back(3); dims.push_back(2);
+    HilbertSpace space(dims);
+    MatrixXcd factor = MatrixXcd::Random(6, 2);
+    // columns 3 and 4 are combinations of the first two, so rank is 2
+    MatrixXcd redundant(6, 4);
+    redundant << factor, factor * MatrixXcd::Random(2, 2);
+    EnsembleState state = EnsembleState::fromFactor(redundant, space);
+    MatrixXcd density = state.densityMatrix();
+    EXPECT_EQ(true, state.truncate() < 1.0e-12);
+    EXPECT_EQ(2, state.rank());
+    EXPECT_EQ(true, state.densityMatrix().isApprox(density));
+    
+    RandomGenerator gen(11);
+    int outcome = state.measure(0, gen);
+    VectorXd probs = state.probabilities();
+    EXPECT_EQ(true, abs(probs.sum() - 1) < 1.0e-12);
+    EXPECT_EQ(true, abs(probs.segment(outcome * 2, 2).sum() - 1) < 1.0e-12);
+    EXPECT_THROW(state.measure(2, gen), std::invalid_argument);
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "../fixed_register.h"
+#include "../circuit.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+#include "../transforms/pauligate.h"
+
+TEST(FixedRegisterTest, TestMatchesCircuit) {
+    Circuit circuit(HilbertSpace(std::vector<uint>(3, 2)));
+    std::vector<int> pair; pair.push_back(2); pair.push_back(0);
+    circuit.addGate(HadamardGate(), 2);
+    circuit.addGate(PhaseShiftGate(0.3), 2);
+    circuit.addGate(CNOTGate(), pair);
+    circuit.addGate(PauliGate(PauliGate::Y), 1);
+    VectorXcd vec = VectorXcd::Zero(8);
+    vec[0] = 1;
+    circuit.applyTo(vec);
+    
+    FixedRegister<3> reg;
+    reg.apply<2>(FixedRegister<3>::hadamard());
+    reg.apply(FixedRegister<3>::phaseShift(0.3), 2);
+    reg.apply<2, 0>(FixedRegister<3>::cnot());
+    reg.apply(FixedRegister<3>::pauliY(), 1);
+    VectorXcd res = reg.amplitudes();
+    EXPECT_EQ(true, vec.isApprox(res));
+    EXPECT_EQ(true, abs(reg.expectationZ(0)) < 1.0e-12);
+    EXPECT_EQ(true, abs(reg.expectationZ(1) + 1) < 1.0e-12);
+    EXPECT_EQ(reg.toQuantumState(), QuantumState(vec, HilbertSpace(std::vector<uint>(3, 2))));
+}
+
+TEST(FixedRegisterTest, TestMeasureBellPair) {
+    RandomGenerator gen(3);
+    int ones = 0;
+    for (int shot = 0; shot < 200; ++shot) {
+	FixedRegister<2> reg;
+	reg.apply<0>(FixedRegister<2>::hadamard());
+	reg.apply(FixedRegister<2>::cnot(), 0, 1);
+	int first = reg.measure(0, gen);
+	EXPECT_EQ(first, reg.measure(1, gen));
+	EXPECT_EQ(true, abs(reg.probabilities().sum() - 1) < 1.0e-12);
+	ones += first;
+    }
+    EXPECT_EQ(true, ones > 60 && ones < 140);
+    
+    FixedRegister<5> wide;
+    wide.apply<4>(FixedRegister<5>::pauliX());
+    wide.apply<4, 0>(FixedRegister<5>::swap());
+    EXPECT_EQ(std::complex<double>(1), wide.amplitudes()[16]);
+}
@@ -112,4 +112,16 @@ TEST_F(HilbertSpaceTest, CheckGetBasisVector) {
     EXPECT_EQ(res, space.getBasisVector(vec));
 }
 
+TEST_F(HilbertSpaceTest, CheckTooLargeSpaceIsRejected) {
+    // 2^31 states do not fit in int; before the check the total dimension silently wrapped to 0
+    EXPECT_EQ(1 << 30, HilbertSpace(std::vector<uint>(30, 2)).totalDimension());
+    EXPECT_THROW(HilbertSpace(std::vector<uint>(31, 2)), std::invalid_argument);
+    EXPECT_THROW(HilbertSpace(std::vector<uint>(48, 2)), std::invalid_argument);
+    EXPECT_THROW(HilbertSpace(3000000000u), std::invalid_argument);
+    
+    HilbertSpace big(std::vector<uint>(20, 2));
+    EXPECT_THROW(big.tensorWith(big), std::invalid_argument);
+    EXPECT_EQ(20, big.rank());
+}
+
 }
@@ -11,4 +11,172 @@ TEST(KroneckerTensorTest, TestProduct) {
 	    18,21,24,28;
     
     EXPECT_EQ(res, KroneckerTensor::product(first, second));
-}
\ No newline at end of file
+}
+namespace {
+// index of amplitude after subsystem i of result is taken from subsystem perm[i]
+int permutedIndex(int index, const std::vector<int>& perm, const std::vector<uint>& dims)
+{
+    std::vector<int> digits(dims.size());
+    for (int i = dims.size() - 1; i >= 0; --i) {
+	digits[i] = index % dims[i];
+	index /= dims[i];
+    }
+    int res = 0;
+    for (int i = 0; i < perm.size(); ++i)
+	res = res * dims[perm[i]] + digits[perm[i]];
+    return res;
+}
+}
+
+TEST(KroneckerTensorTest, TestPermuteSubsystems) {
+    // dimensions 2, 3, 2; result order is (2, 0, 1)
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3); dims.push_back(2);
+    std::vector<int> perm; perm.push_back(2); perm.push_back(0); perm.push_back(1);
+    VectorXcd vec(12);
+    MatrixXcd matr(12, 12);
+    for (int i = 0; i < 12; ++i) {
+	vec[i] = std::complex<double>(i, -i);
+	for (int j = 0; j < 12; ++j)
+	    matr(i, j) = std::complex<double>(i, j);
+    }
+    
+    // old index (a, b, c) = 6a + 2b + c goes to new index (c, a, b) = 6c + 3a + b
+    VectorXcd expectedVec(12);
+    MatrixXcd expectedMatr(12, 12);
+    for (int i = 0; i < 12; ++i) {
+	int newI = 6 * (i % 2) + 3 * (i / 6) + (i / 2) % 3;
+	expectedVec[newI] = vec[i];
+	for (int j = 0; j < 12; ++j)
+	    expectedMatr(newI, 6 * (j % 2) + 3 * (j / 6) + (j / 2) % 3) = matr(i, j);
+    }
+    
+    MatrixXcd target = vec;
+    KroneckerTensor::permuteSubsystems(perm, dims, target);
+    EXPECT_EQ(expectedVec, target.col(0));
+    target = matr;
+    KroneckerTensor::permuteSubsystems(perm, dims, target, 3);
+    EXPECT_EQ(expectedMatr, target);
+    
+    // swap of the first two qubits of four, the last two are copied as segments and work is shared between threads
+    std::vector<uint> qubits(4, 2);
+    std::vector<int> swap; swap.push_back(1); swap.push_back(0); swap.push_back(2); swap.push_back(3);
+    MatrixXcd big = MatrixXcd::Random(16, 16);
+    MatrixXcd swapMatr(4, 4);
+    swapMatr << 1,0,0,0, 0,0,1,0, 0,1,0,0, 0,0,0,1;
+    MatrixXcd swapGate = KroneckerTensor::product(swapMatr, KroneckerTensor::getIdentityMatrix(4));
+    target = big;
+    KroneckerTensor::permuteSubsystems(swap, qubits, target, 4);
+    EXPECT_EQ(true, (swapGate * big * swapGate.adjoint()).isApprox(target));
+    target = big;
+    std::vector<int> first; first.push_back(0); first.push_back(1);
+    KroneckerTensor::applyToSubsystems(swapMatr, first, qubits, target);
+    EXPECT_EQ(true, (swapGate * big).isApprox(target));
+    
+    EXPECT_THROW(KroneckerTensor::permuteSubsystems(std::vector<int>(3, 0), dims, target), std::invalid_argument);
+}
+
+TEST(KroneckerTensorTest, TestSwapSubsystemsInPlace) {
+    std::vector<uint> dims; dims.push_back(3); dims.push_back(2); dims.push_back(3);
+    std::vector<int> perm; perm.push_back(2); perm.push_back(1); perm.push_back(0);
+    MatrixXcd matr(18, 18);
+    for (int i = 0; i < 18; ++i)
+	for (int j = 0; j < 18; ++j)
+	    matr(i, j) = std::complex<double>(i, j);
+    MatrixXcd both(18, 18), rows(18, 18);
+    for (int i = 0; i < 18; ++i)
+	for (int j = 0; j < 18; ++j) {
+	    both(permutedIndex(i, perm, dims), permutedIndex(j, perm, dims)) = matr(i, j);
+	    rows(permutedIndex(i, perm, dims), j) = matr(i, j);
+	}
+    
+    MatrixXcd target = matr;
+    KroneckerTensor::swapSubsystems(0, 2, dims, target);
+    EXPECT_EQ(both, target);
+    target = matr;
+    KroneckerTensor::swapSubsystems(2, 0, dims, target, false);
+    EXPECT_EQ(rows, target);
+    EXPECT_THROW(KroneckerTensor::swapSubsystems(0, 1, dims, target), std::invalid_argument);
+    
+    // SWAP gate matrix goes to the in-place kernel and gives the same as the general one
+    MatrixXcd swapQutrits = MatrixXcd::Zero(9, 9);
+    for (int a = 0; a < 3; ++a)
+	for (int b = 0; b < 3; ++b)
+	    swapQutrits(b * 3 + a, a * 3 + b) = 1;
+    std::vector<int> pair; pair.push_back(2); pair.push_back(0);
+    target = matr;
+    KroneckerTensor::applyToSubsystems(swapQutrits, pair, dims, target);
+    EXPECT_EQ(rows, target);
+    MatrixXcd general = matr;
+    for (int col = 0; col < 18; ++col)
+	KroneckerTensor::applyToSubsystems(swapQutrits, pair, dims, general.col(col).data(), 0, 18);
+    EXPECT_EQ(general, target);
+}
+
+TEST(KroneckerTensorTest, TestPermuteQubitsInPlaceWithThreads) {
+    // 256 x 256 is big enough for threads; cycle 0 -> 5 -> 2 -> 0 and swap of 3 and 7 are done as in-place swaps
+    std::vector<uint> dims(8, 2);
+    std::vector<int> perm;
+    int order[8] = {2, 1, 5, 7, 4, 0, 6, 3};
+    perm.assign(order, order + 8);
+    MatrixXcd matr(256, 256), vec(65536, 1);
+    for (int i = 0; i < 256; ++i)
+	for (int j = 0; j < 256; ++j)
+	    matr(i, j) = std::complex<double>(i, j);
+    MatrixXcd expected(256, 256);
+    for (int i = 0; i < 256; ++i)
+	for (int j = 0; j < 256; ++j)
+	    expected(permutedIndex(i, perm, dims), permutedIndex(j, perm, dims)) = matr(i, j);
+    KroneckerTensor::permuteSubsystems(perm, dims, matr, 4);
+    EXPECT_EQ(expected, matr);
+    
+    std::vector<uint> wide(16, 2);
+    for (int i = 0; i < 65536; ++i)
+	vec(i, 0) = i;
+    KroneckerTensor::swapSubsystems(3, 12, wide, vec, true, 4);
+    std::vector<int> swap(16);
+    for (int i = 0; i < 16; ++i)
+	swap[i] = i;
+    std::swap(swap[3], swap[12]);
+    bool same = true;
+    for (int i = 0; i < 65536; ++i)
+	same = same && vec(permutedIndex(i, swap, wide), 0) == std::complex<double>(i);
+    EXPECT_EQ(true, same);
+}
+
+TEST(KroneckerTensorTest, TestApplyToGroupRanges) {
+    // qubit, qutrit, qubit; groups of the qutrit gate are numbered by the two qubits
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3); dims.push_back(2);
+    MatrixXcd op(3, 3);
+    op << 0, 1, 0,
+	  0, 0, 1,
+	  1, 0, 0;
+    std::vector<int> middle(1, 1);
+    VectorXcd vec(12), whole;
+    for (int i = 0; i < 12; ++i)
+	vec[i] = i;
+    whole = vec;
+    KroneckerTensor::applyToSubsystems(op, middle, dims, whole.data(), 0, 100);
+    
+    // first two groups are exactly the first half of the vector, the rest is untouched
+    VectorXcd parts = vec;
+    KroneckerTensor::applyToSubsystems(op, middle, dims, parts.data(), 0, 2);
+    EXPECT_EQ(whole.head(6), parts.head(6));
+    EXPECT_EQ(vec.tail(6), parts.tail(6));
+    KroneckerTensor::applyToSubsystems(op, middle, dims, parts.data(), 2, 3);
+    KroneckerTensor::applyToSubsystems(op, middle, dims, parts.data(), 3, 4);
+    EXPECT_EQ(whole, parts);
+    EXPECT_EQ(std::complex<double>(2), whole[0]);
+    EXPECT_EQ(std::complex<double>(0), whole[4]);
+}
+
+TEST(KroneckerTensorTest, TestRepeatedSubsystemIsRejected) {
+    std::vector<uint> dims(2, 2);
+    MatrixXcd cnot = MatrixXcd::Identity(4, 4);
+    cnot.bottomRightCorner(2, 2) << 0, 1, 1, 0;
+    std::vector<int> twice(2, 0);
+    MatrixXcd vec = MatrixXcd::Ones(4, 1);
+    EXPECT_THROW(KroneckerTensor::applyToSubsystems(cnot, twice, dims, vec), std::invalid_argument);
+    EXPECT_THROW(KroneckerTensor::applyToSubsystems(cnot, twice, dims, vec.data(), 0, 4), std::invalid_argument);
+    EXPECT_EQ(MatrixXcd::Ones(4, 1), vec);
+    EXPECT_EQ(4, KroneckerTensor::localDimension(std::vector<int>(1, 1), std::vector<uint>(2, 4)));
+}
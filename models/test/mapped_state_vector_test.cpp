@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "../mapped_state_vector.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+
+namespace {
+std::vector<int> pair(int a, int b)
+{
+    std::vector<int> res; res.push_back(a); res.push_back(b);
+    return res;
+}
+}
+
+TEST(MappedStateVectorTest, TestMatchesInMemoryVector) {
+    Circuit circuit(HilbertSpace(std::vector<uint>(7, 2)));
+    for (int layer = 0; layer < 3; ++layer) {
+	for (int q = 0; q < 7; ++q) {
+	    circuit.addGate(HadamardGate(), q);
+	    circuit.addGate(PhaseShiftGate(0.4 * q - layer), q);
+	}
+	for (int q = layer % 2; q + 1 < 7; q += 2)
+	    circuit.addGate(CNOTGate(), pair(q, q + 1));
+	circuit.addGate(CNOTGate(), pair(6, 0));
+    }
+    VectorXcd vec = VectorXcd::Zero(128);
+    vec[0] = 1;
+    circuit.applyTo(vec);
+    
+    MappedStateVector mapped(circuit.dimensions(), "mapped_state_vector_test.bin", 3);
+    EXPECT_EQ(16, mapped.chunksCount());
+    mapped.apply(circuit);
+    EXPECT_EQ(true, vec.isApprox(mapped.toVector()));
+    EXPECT_EQ(true, mapped.swapsCount() > 0);
+    EXPECT_EQ(true, mapped.passesCount() < circuit.gatesCount());
+    
+    std::vector<int> digits(7, 1);
+    EXPECT_EQ(true, abs(vec[127] - mapped.amplitude(digits)) < 1.0e-12);
+    
+    // layout is a permutation of slots
+    std::vector<int> layout = mapped.layout();
+    std::sort(layout.begin(), layout.end());
+    for (int s = 0; s < 7; ++s)
+	EXPECT_EQ(s, layout[s]);
+}
+
+TEST(MappedStateVectorTest, TestWrongArguments) {
+    std::vector<uint> dims(3, 2);
+    EXPECT_THROW(MappedStateVector(dims, "mapped_state_vector_test.bin", 0), std::invalid_argument);
+    EXPECT_THROW(MappedStateVector(dims, "/nonexistent/dir/state.bin", 2), std::runtime_error);
+    EXPECT_THROW(MappedStateVector(std::vector<uint>(64, 2), "mapped_state_vector_test.bin", 2), std::invalid_argument);
+    
+    MappedStateVector mapped(dims, "mapped_state_vector_test.bin", 1);
+    Circuit circuit(dims);
+    circuit.addGate(CNOTGate(), pair(0, 2));
+    EXPECT_THROW(mapped.apply(circuit), std::invalid_argument);
+    EXPECT_THROW(mapped.apply(Circuit(std::vector<uint>(4, 2))), std::invalid_argument);
+}
+
+TEST(MappedStateVectorTest, TestRegisterWiderThanInt) {
+    // 2^32 amplitudes (64 GiB) in sparse file; only the page of the first amplitude is written
+    std::vector<uint> dims(32, 2);
+    MappedStateVector mapped(dims, "mapped_state_vector_test.bin", 20);
+    EXPECT_EQ(1LL << 32, mapped.size());
+    EXPECT_EQ(1LL << 20, mapped.chunkSize());
+    EXPECT_EQ(1LL << 12, mapped.chunksCount());
+    EXPECT_EQ(dims, mapped.dimensions());
+    EXPECT_EQ(std::complex<double>(1), mapped.amplitude(std::vector<int>(32, 0)));
+    EXPECT_EQ(std::complex<double>(0), mapped.amplitude(std::vector<int>(32, 1)));
+    EXPECT_THROW(mapped.space(), std::invalid_argument);
+}
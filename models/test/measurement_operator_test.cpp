@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include "../measurement_operator.h"
+#include "../measurement.h"
+#include "../kronecker_tensor.h"
+
+namespace {
+// seeded entries in [-1, 1), so inputs do not depend on rand() calls of other tests
+MatrixXcd randomMatrix(int rows, int cols, uint64_t seed)
+{
+    RandomGenerator gen(seed);
+    MatrixXcd res(rows, cols);
+    for (int col = 0; col < cols; ++col)
+	for (int row = 0; row < rows; ++row)
+	    res(row, col) = std::complex<double>(2 * gen.uniform() - 1, 2 * gen.uniform() - 1);
+    return res;
+}
+
+MatrixXcd randomDensity(int size, uint64_t seed)
+{
+    MatrixXcd a = randomMatrix(size, size, seed);
+    MatrixXcd density = a * a.adjoint();
+    return density / density.trace();
+}
+}
+
+TEST(MeasurementOperatorTest, TestFactoredMatchesDense) {
+    MatrixXcd factor = randomMatrix(4, 2, 1);
+    MatrixXcd dense = factor * factor.adjoint();
+    MatrixXcd density = randomDensity(4, 2);
+    
+    MeasurementOperator factored = MeasurementOperator::fromFactor(factor), plain(dense);
+    
+    EXPECT_EQ(MeasurementOperator::Factored, factored.representation());
+    EXPECT_EQ(4, factored.dimension());
+    EXPECT_EQ(true, dense.isApprox(factored.toDense()));
+    EXPECT_EQ(true, abs(plain.probability(density) - factored.probability(density)) < 1.0e-12);
+    EXPECT_EQ(true, plain.collapse(density).isApprox(factored.collapse(density)));
+    EXPECT_EQ(true, plain.sqrtMatrix().isApprox(factored.sqrtMatrix()));
+}
+
+TEST(MeasurementOperatorTest, TestSqrtOfRankDeficientDense) {
+    // eigen values of v * v^+ other than |v|^2 are zero up to rounding, their roots must be dropped
+    MatrixXcd v = randomMatrix(4, 1, 8);
+    MeasurementOperator op(MatrixXcd(v * v.adjoint()));
+    MatrixXcd expected = v * v.adjoint() / v.norm();
+    EXPECT_EQ(true, expected.isApprox(op.sqrtMatrix(), 1.0e-12));
+}
+
+TEST(MeasurementOperatorTest, TestSparseMatchesDense) {
+    SparseMatrixXcd sparse(4, 4);
+    sparse.insert(1, 1) = 0.25;
+    sparse.insert(3, 3) = 1;
+    MatrixXcd density = randomDensity(4, 3);
+    
+    MatrixXcd dense = MatrixXcd(sparse);
+    MeasurementOperator op(sparse), plain(dense);
+    
+    EXPECT_EQ(MeasurementOperator::Sparse, op.representation());
+    EXPECT_EQ(true, op.isHermit());
+    EXPECT_EQ(true, op.isPositive());
+    EXPECT_EQ(true, abs(plain.probability(density) - op.probability(density)) < 1.0e-12);
+    EXPECT_EQ(true, plain.collapse(density).isApprox(op.collapse(density)));
+}
+
+TEST(MeasurementOperatorTest, TestMeasurementWithFactoredAndSparseOperators) {
+    Vector2cd plus(1, 1), minus(1, -1);
+    plus.normalize(); minus.normalize();
+    SparseMatrixXcd zero(2, 2);
+    zero.insert(0, 0) = 1;
+    
+    Measurement measure;
+    measure.addFactoredOperator(plus * std::sqrt(0.5), "+");
+    measure.addFactoredOperator(minus * std::sqrt(0.5), "-");
+    measure.addOperator(SparseMatrixXcd(zero * 0.5), "0");
+    SparseMatrixXcd one(2, 2);
+    one.insert(1, 1) = 0.5;
+    measure.addOperator(one, "1");
+    
+    EXPECT_EQ(true, measure.isValid());
+    
+    QuantumState state(Vector2cd(1, 0), HilbertSpace(2));
+    std::map<std::string, double> probs = measure.probabilities(state);
+    EXPECT_EQ(true, abs(0.25 - probs["+"]) < 1.0e-12);
+    EXPECT_EQ(true, abs(0.5 - probs["0"]) < 1.0e-12);
+    EXPECT_EQ(true, abs(probs["1"]) < 1.0e-12);
+}
+
+TEST(MeasurementOperatorTest, TestFactoredOnSubsystemMatchesExpanded) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3);
+    HilbertSpace space(dims);
+    MatrixXcd basis = MatrixXcd::Identity(3, 3);
+    
+    Measurement factored, dense;
+    for (int i = 0; i < 3; ++i) {
+	factored.addFactoredOperator(basis.col(i), "x");
+	dense.addOperator(basis.col(i) * basis.col(i).adjoint(), "x");
+    }
+    factored.addFactoredOperator(MatrixXcd::Zero(3, 1), "none"); // labels must differ in map
+    dense.addOperator(MatrixXcd::Zero(3, 3), "none");
+    
+    VectorXcd vec(6); vec << 1, 2, 0, 1, -1, 3;
+    QuantumState first(vec, space), second(vec, space);
+    RandomGenerator gen1(9), gen2(9);
+    factored.performOn(&first, gen1, 1);
+    dense.performOn(&second, gen2, 1);
+    
+    EXPECT_EQ(first, second);
+}
+
+TEST(MeasurementOperatorTest, TestApplyToSubsystemsMatchesExpand) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3); dims.push_back(2);
+    MatrixXcd op = randomMatrix(3, 3, 4);
+    MatrixXcd target = randomMatrix(12, 5, 5);
+    MatrixXcd expected = KroneckerTensor::expand(op, 1, dims) * target;
+    
+    KroneckerTensor::applyToSubsystem(op, 1, dims, target);
+    EXPECT_EQ(true, expected.isApprox(target));
+    
+    std::vector<int> pair; pair.push_back(2); pair.push_back(0); // operator acts on |q2 q0>
+    MatrixXcd op2 = randomMatrix(4, 4, 6);
+    MatrixXcd vec = randomMatrix(12, 1, 7), res = vec;
+    KroneckerTensor::applyToSubsystems(op2, pair, dims, res);
+    for (int i = 0; i < 12; ++i) {
+	int q0 = i / 6, q1 = (i / 2) % 3, q2 = i % 2;
+	std::complex<double> value = 0;
+	for (int a = 0; a < 4; ++a)
+	    value += op2(q2 * 2 + q0, a) * vec((a % 2) * 6 + q1 * 2 + a / 2, 0);
+	EXPECT_EQ(true, abs(value - res(i, 0)) < 1.0e-12);
+    }
+}
@@ -150,4 +150,67 @@ TEST(MeasurementTest, TestPerformingOnSubsystem) {
 	EXPECT_EQ(true, pr.isApprox(state.densityMatrix())); // state |11>
 	EXPECT_EQ(true, prPart.isApprox(state.partialTrace(0).densityMatrix())); // second qubit in |1>
     }
-}
\ No newline at end of file
+}
+TEST(MeasurementTest, TestProectorOnLargeSpaceIsImplicit) {
+    std::vector<uint> dims(12, 2);
+    HilbertSpace space(dims);
+    Proector measure(space);
+    
+    EXPECT_EQ(true, measure.isValid()); // no 4096 projectors 4096x4096 were built to get here
+    
+    QuantumState qubit(Vector2cd(1,1), HilbertSpace(2));
+    EXPECT_ANY_THROW(measure.probabilities(qubit));
+}
+
+TEST(MeasurementTest, TestProectorMatchesExplicitProjectors) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3);
+    HilbertSpace space(dims);
+    VectorXcd vec(6); vec << 1, 2, 0, 1, -1, 3;
+    QuantumState state(vec, space);
+    
+    Proector implicit(HilbertSpace(3));
+    Measurement explicitMeasure(implicit.operators(), implicit.labels());
+    
+    std::map<std::string, double> expected = explicitMeasure.probabilities(state, 1);
+    std::map<std::string, double> actual = implicit.probabilities(state, 1);
+    ASSERT_EQ(3, actual.size());
+    for (std::map<std::string, double>::iterator it = expected.begin(); it != expected.end(); ++it)
+	EXPECT_EQ(true, abs(it->second - actual[it->first]) < 1.0e-12);
+    
+    QuantumState implicitState = state, explicitState = state;
+    RandomGenerator first(3), second(3);
+    EXPECT_EQ(explicitMeasure.performOn(&explicitState, first, 1), implicit.performOn(&implicitState, second, 1));
+    EXPECT_EQ(explicitState, implicitState);
+}
+
+TEST(MeasurementTest, TestProectorLabels) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(2);
+    Proector measure((HilbertSpace(dims)));
+    
+    std::vector<std::string> labels = measure.labels();
+    ASSERT_EQ(4, labels.size());
+    EXPECT_EQ("|0,0><0,0|", labels[0]);
+    EXPECT_EQ("|1,0><1,0|", labels[2]);
+    EXPECT_EQ(4, measure.operators().size());
+}
+
+TEST(MeasurementTest, TestOutcomeIndices) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(12);
+    Proector measure((HilbertSpace(dims)));
+    
+    EXPECT_EQ(24, measure.outcomesCount());
+    EXPECT_EQ("|1,11><1,11|", measure.label(23));
+    EXPECT_EQ("|0,10><0,10|", measure.label(10));
+    EXPECT_ANY_THROW(measure.label(24));
+    
+    Measurement qubit = Proector(HilbertSpace(2));
+    QuantumState state(Vector2cd(1,3), HilbertSpace(2));
+    std::vector<double> probs = qubit.outcomeProbabilities(state);
+    ASSERT_EQ(2, probs.size());
+    EXPECT_EQ(true, abs(0.1 - probs[0]) < 1.0e-12);
+    EXPECT_EQ(true, abs(0.9 - probs[1]) < 1.0e-12);
+    
+    RandomGenerator gen(1);
+    int outcome = qubit.performOutcome(&state, gen);
+    EXPECT_EQ(true, abs(1 - qubit.outcomeProbabilities(state)[outcome]) < 1.0e-12);
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include "../packed_density_matrix.h"
+#include "../kronecker_tensor.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+
+TEST(PackedDensityMatrixTest, TestMatchesFullMatrix) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3); dims.push_back(2);
+    HilbertSpace space(dims);
+    MatrixXcd a = MatrixXcd::Random(12, 12);
+    MatrixXcd density = a * a.adjoint();
+    density /= density.trace();
+    QuantumState state(density, space);
+    
+    PackedDensityMatrix packed(state);
+    EXPECT_EQ(78, packed.packed().size());
+    EXPECT_EQ(true, packed.densityMatrix().isApprox(density));
+    EXPECT_EQ(true, abs(packed.purity() - state.purity()) < 1.0e-12);
+    EXPECT_EQ(true, packed.probabilities().isApprox(density.diagonal().real()));
+    
+    MatrixXcd qutrit = MatrixXcd::Identity(3, 3);
+    qutrit.topLeftCorner(2, 2) = HadamardGate().transformMatrix();
+    std::vector<int> pair; pair.push_back(2); pair.push_back(0);
+    packed.apply(qutrit, std::vector<int>(1, 1));
+    packed.apply(CNOTGate().transformMatrix(), pair);
+    packed.apply(PhaseShiftGate(0.4).transformMatrix(), std::vector<int>(1, 0));
+    KroneckerTensor::applyToSubsystem(qutrit, 1, dims, density);
+    density.adjointInPlace();
+    KroneckerTensor::applyToSubsystem(qutrit, 1, dims, density);
+    KroneckerTensor::applyToSubsystems(CNOTGate().transformMatrix(), pair, dims, density);
+    density.adjointInPlace();
+    KroneckerTensor::applyToSubsystems(CNOTGate().transformMatrix(), pair, dims, density);
+    MatrixXcd phase = KroneckerTensor::expand(PhaseShiftGate(0.4).transformMatrix(), 0, dims);
+    density = phase * density * phase.adjoint();
+    EXPECT_EQ(true, packed.densityMatrix().isApprox(density));
+    EXPECT_THROW(packed.apply(CNOTGate().transformMatrix(), std::vector<int>(2, 0)), std::invalid_argument);
+    EXPECT_EQ(true, packed.densityMatrix().isApprox(density));
+    
+    QuantumState evolved(density, space);
+    for (int i = 0; i < 3; ++i)
+	EXPECT_EQ(evolved.partialTrace(i), packed.partialTrace(i).toQuantumState());
+    EXPECT_EQ(true, abs(packed.partialTrace(1).purity() - evolved.partialTrace(1).purity()) < 1.0e-12);
+}
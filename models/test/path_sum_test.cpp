@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "../path_sum.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+#include "../transforms/toffoligate.h"
+#include "../transforms/pauligate.h"
+
+namespace {
+std::vector<int> list(int a, int b, int c = -1)
+{
+    std::vector<int> res; res.push_back(a); res.push_back(b);
+    if (c >= 0) res.push_back(c);
+    return res;
+}
+}
+
+TEST(PathSumTest, TestAmplitudesMatchStateVector) {
+    Circuit circuit(HilbertSpace(std::vector<uint>(4, 2)));
+    for (int layer = 0; layer < 3; ++layer) {
+	for (int q = 0; q < 4; ++q) {
+	    circuit.addGate(HadamardGate(), q);
+	    circuit.addGate(PhaseShiftGate(0.7 * q + layer), q);
+	}
+	for (int q = layer % 2; q + 1 < 4; q += 2)
+	    circuit.addGate(CNOTGate(), list(q, q + 1));
+    }
+    VectorXcd vec = VectorXcd::Zero(16);
+    vec[0] = 1;
+    circuit.applyTo(vec);
+    
+    PathSum single(circuit, 1), parallel(circuit, 4);
+    for (int i = 0; i < 16; ++i) {
+	std::vector<int> outcome(4);
+	for (int q = 0; q < 4; ++q)
+	    outcome[q] = (i >> (3 - q)) & 1;
+	std::complex<double> amp = single.amplitude(outcome);
+	EXPECT_EQ(true, abs(vec[i] - amp) < 1.0e-12);
+	EXPECT_EQ(amp, parallel.amplitude(outcome)); // the same order of summation
+    }
+    EXPECT_EQ(12, single.branchingGatesCount());
+}
+
+TEST(PathSumTest, TestPermutationGatesDoNotBranch) {
+    // reversible adder-like circuit on 5 qubits from |10110>
+    Circuit circuit(HilbertSpace(std::vector<uint>(5, 2)));
+    circuit.addGate(ToffoliGate(), list(0, 2, 4));
+    circuit.addGate(CNOTGate(), list(0, 1));
+    circuit.addGate(PhaseShiftGate(1.0), 3);
+    circuit.addGate(CNOTGate(), list(3, 4));
+    PathSum sum(circuit);
+    EXPECT_EQ(0, sum.branchingGatesCount());
+    
+    std::vector<int> input(5, 0);
+    input[0] = input[2] = input[3] = 1;
+    std::vector<int> output = input;
+    output[1] = 1; output[4] = 0; // Toffoli sets qubit 4, CNOT from qubit 3 clears it
+    EXPECT_EQ(true, abs(sum.amplitude(output, input) - std::polar(1.0, 1.0)) < 1.0e-12);
+    EXPECT_EQ(std::complex<double>(0), sum.amplitude(input, input));
+    
+    std::vector<int> untouched(5, 0);
+    Circuit empty(HilbertSpace(std::vector<uint>(5, 2)));
+    untouched[2] = 1;
+    EXPECT_EQ(std::complex<double>(0), PathSum(empty).amplitude(untouched));
+    EXPECT_THROW(sum.amplitude(std::vector<int>(4, 0)), std::invalid_argument);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include "../pauli_string.h"
+#include "../kronecker_tensor.h"
+#include "../transforms/pauligate.h"
+
+namespace {
+MatrixXcd paulisToMatrix(const std::string& paulis)
+{
+    MatrixXcd res = MatrixXcd::Identity(1, 1);
+    for (int q = 0; q < paulis.size(); ++q) {
+	MatrixXcd op = MatrixXcd::Identity(2, 2);
+	if (paulis[q] == 'X') op = PauliGate(PauliGate::X).transformMatrix();
+	if (paulis[q] == 'Y') op = PauliGate(PauliGate::Y).transformMatrix();
+	if (paulis[q] == 'Z') op = PauliGate(PauliGate::Z).transformMatrix();
+	res = KroneckerTensor::product(res, op);
+    }
+    return res;
+}
+}
+
+TEST(PauliStringTest, TestMasksAndMatrix) {
+    PauliString p("XIZY", 0.5);
+    
+    EXPECT_EQ(4, p.qubits());
+    EXPECT_EQ("XIZY", p.toString());
+    EXPECT_EQ((uint64_t) 9, p.xMask());
+    EXPECT_EQ((uint64_t) 3, p.zMask());
+    EXPECT_EQ(1, p.phase());
+    EXPECT_EQ(true, (0.5 * paulisToMatrix("XIZY")).isApprox(p.matrix()));
+    EXPECT_EQ("XIZY", PauliString(9, 3, 4).toString());
+    EXPECT_ANY_THROW(PauliString("XA"));
+}
+
+TEST(PauliStringTest, TestExpectationMatchesDense) {
+    const char* strings[] = { "III", "XYZ", "YYI", "ZIX", "IYI" };
+    std::vector<uint> dims(3, 2);
+    VectorXcd vec = VectorXcd::Random(8); vec.normalize();
+    QuantumState state(vec, HilbertSpace(dims));
+    MatrixXcd density = vec * vec.adjoint();
+    
+    for (int i = 0; i < 5; ++i) {
+	PauliString p(strings[i], std::complex<double>(0.3, 0));
+	std::complex<double> expected = (density * p.matrix()).trace();
+	EXPECT_EQ(true, abs(expected - p.expectation(vec)) < 1.0e-12);
+	EXPECT_EQ(true, abs(expected - p.expectation(state)) < 1.0e-12);
+    }
+}
+
+TEST(PauliStringTest, TestCommutation) {
+    EXPECT_EQ(false, PauliString("XI").commutesWith(PauliString("ZI")));
+    EXPECT_EQ(true, PauliString("XX").commutesWith(PauliString("ZZ")));
+    EXPECT_EQ(true, PauliString("XY").commutesWith(PauliString("IY")));
+}
+
+TEST(PauliStringTest, TestSum) {
+    PauliSum sum;
+    sum.addTerm(PauliString("ZZ", -1));
+    sum.addTerm(PauliString("XI", 0.5));
+    sum.addTerm(PauliString("IX", 0.5));
+    EXPECT_ANY_THROW(sum.addTerm(PauliString("X")));
+    
+    Vector4cd vec(1, 0, 0, 1); vec.normalize(); // EPR
+    EXPECT_EQ(true, abs(std::complex<double>(-1, 0) - sum.expectation(vec)) < 1.0e-12);
+    
+    std::vector<uint> dims(2, 2);
+    QuantumState state(vec, HilbertSpace(dims));
+    EXPECT_EQ(true, abs(sum.expectation(vec) - sum.expectation(state)) < 1.0e-12);
+    EXPECT_EQ(true, abs((state.densityMatrix() * sum.matrix()).trace() - sum.expectation(state)) < 1.0e-12);
+}
+
+TEST(PauliStringTest, TestQubitWiseCommutingGroups) {
+    EXPECT_EQ(true, PauliString("XIZ").qubitWiseCommutesWith(PauliString("XZI")));
+    EXPECT_EQ(false, PauliString("XX").qubitWiseCommutesWith(PauliString("ZZ")));
+    
+    PauliSum sum;
+    sum.addTerm(PauliString("ZZI"));
+    sum.addTerm(PauliString("XXI"));
+    sum.addTerm(PauliString("IZZ"));
+    sum.addTerm(PauliString("XIY"));
+    std::vector< std::vector<int> > groups = sum.qubitWiseCommutingGroups();
+    
+    ASSERT_EQ(2, groups.size());
+    ASSERT_EQ(2, groups[0].size()); // ZZI, IZZ
+    EXPECT_EQ(2, groups[0][1]);
+    ASSERT_EQ(2, groups[1].size()); // XXI, XIY
+    EXPECT_EQ(3, groups[1][1]);
+}
+
+TEST(PauliStringTest, TestEstimateByGroupsMatchesExpectation) {
+    const char* strings[] = { "ZZI", "XXI", "IZZ", "XIY", "YYY", "IIX", "III" };
+    PauliSum sum;
+    for (int i = 0; i < 7; ++i)
+	sum.addTerm(PauliString(strings[i], 0.1 * (i + 1)));
+    
+    VectorXcd vec = VectorXcd::Random(8); vec.normalize();
+    std::vector<uint> dims(3, 2);
+    QuantumState state(vec, HilbertSpace(dims));
+    
+    PauliEstimates fromVector = sum.estimateByGroups(vec, 100);
+    PauliEstimates fromState = sum.estimateByGroups(state, 100);
+    std::vector<PauliString> terms = sum.terms();
+    for (int i = 0; i < 7; ++i) {
+	std::complex<double> expected = terms[i].expectation(vec);
+	EXPECT_EQ(true, abs(expected - fromVector.values[i]) < 1.0e-12);
+	EXPECT_EQ(true, abs(expected - fromState.values[i]) < 1.0e-12);
+	double bare = (expected / terms[i].coefficient()).real();
+	EXPECT_EQ(true, abs(std::norm(terms[i].coefficient()) * (1 - bare * bare) / 100 - fromVector.variances[i]) < 1.0e-12);
+    }
+    EXPECT_EQ(true, abs(fromState.variances[6]) < 1.0e-12); // identity has no variance
+}
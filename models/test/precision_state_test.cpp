@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include "../precision_state.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+#include "../transforms/pauligate.h"
+
+TEST(PrecisionStateTest, TestSinglePrecisionTracksDouble) {
+    std::vector<uint> dims(6, 2);
+    Circuit circuit((HilbertSpace(dims)));
+    for (int layer = 0; layer < 20; ++layer)
+	for (int q = 0; q < 6; ++q) {
+	    std::vector<int> pair; pair.push_back(q); pair.push_back((q + 1) % 6);
+	    circuit.addGate(HadamardGate(), q);
+	    circuit.addGate(PhaseShiftGate(0.1 * (layer + q)), q);
+	    circuit.addGate(CNOTGate(), pair);
+	}
+    VectorXcd exact = VectorXcd::Zero(64);
+    exact[0] = 1;
+    circuit.applyTo(exact);
+    
+    PrecisionState<double> full(dims);
+    MixedPrecisionState mixed(dims);
+    full.apply(circuit);
+    mixed.apply(circuit);
+    EXPECT_EQ(true, (full.toVector() - exact).norm() < 1.0e-12);
+    double error = (mixed.toVector() - exact).norm();
+    EXPECT_EQ(true, error > 1.0e-9);
+    EXPECT_EQ(true, error < mixed.errorBound());
+    EXPECT_EQ(true, mixed.errorBound() < 1.0e-3);
+    EXPECT_EQ(true, mixed.normDrift() < 2 * mixed.errorBound());
+    EXPECT_EQ(true, full.errorBound() < mixed.errorBound() * 1.0e-8);
+    
+    MatrixXcd z = PauliGate(PauliGate::Z).transformMatrix();
+    double expected = 0;
+    for (int i = 0; i < 64; ++i)
+	expected += (i & 4 ? -1 : 1) * std::norm(exact[i]);
+    EXPECT_EQ(true, abs(mixed.expectation(z, std::vector<int>(1, 3)) - expected) < 1.0e-5);
+    EXPECT_EQ(true, abs(mixed.probabilities().sum() - 1) < 1.0e-5);
+    mixed.normalize();
+    EXPECT_EQ(true, mixed.normDrift() < 1.0e-6);
+}
+
+TEST(PrecisionStateTest, TestMeasureCollapses) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3);
+    VectorXcd vec = VectorXcd::Zero(6);
+    vec[1] = vec[4] = sqrt(0.5);
+    RandomGenerator gen(5);
+    for (int shot = 0; shot < 20; ++shot) {
+	MixedPrecisionState state(vec, dims);
+	EXPECT_EQ(1, state.measure(1, gen));
+	int first = state.measure(0, gen);
+	EXPECT_EQ(true, abs(state.probabilities()[first * 3 + 1] - 1) < 1.0e-6);
+	EXPECT_EQ(state.toQuantumState(), QuantumState((VectorXcd) VectorXcd::Unit(6, first * 3 + 1), HilbertSpace(dims)));
+    }
+}
+
+TEST(PrecisionStateTest, TestKeyedOnDimensions) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3);
+    MixedPrecisionState state(dims);
+    EXPECT_EQ(dims, state.dimensions());
+    EXPECT_EQ(HilbertSpace(dims), state.space());
+    
+    // the same total dimension in other subsystems is a different space
+    std::vector<uint> swapped; swapped.push_back(3); swapped.push_back(2);
+    EXPECT_THROW(state.apply(Circuit(swapped)), std::invalid_argument);
+    EXPECT_THROW(state.apply(MatrixXcd::Identity(4, 4), std::vector<int>(2, 0)), std::invalid_argument);
+    EXPECT_THROW(MixedPrecisionState(std::vector<uint>(64, 2)), std::invalid_argument);
+    EXPECT_THROW(MixedPrecisionState(VectorXcd::Zero(5), dims), std::invalid_argument);
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include "../product_state.h"
+#include "../kronecker_tensor.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/pauligate.h"
+
+namespace {
+std::vector<QuantumState> zeroQubits(int n)
+{
+    return std::vector<QuantumState>(n, QuantumState(Vector2cd(1, 0), HilbertSpace(2)));
+}
+}
+
+TEST(ProductStateTest, TestLocalGatesKeepFactors) {
+    ProductState state(zeroQubits(3));
+    state.apply(HadamardGate(), 0);
+    state.apply(PauliGate(PauliGate::X), 2);
+    
+    EXPECT_EQ(3, state.factorsCount());
+    Matrix2cd plus; plus.setConstant(0.5);
+    EXPECT_EQ(true, plus.isApprox(state.factor(0).densityMatrix()));
+    
+    std::vector<uint> dims(3, 2);
+    VectorXcd expected = VectorXcd::Zero(8);
+    expected[1] = expected[5] = 1; // (|0> + |1>) |0> |1>
+    EXPECT_EQ(QuantumState(expected, HilbertSpace(dims)), state.toQuantumState());
+}
+
+TEST(ProductStateTest, TestEntanglingGateMergesOnlyTouchedFactors) {
+    ProductState state(zeroQubits(4));
+    state.apply(HadamardGate(), 3);
+    std::vector<int> pair; pair.push_back(3); pair.push_back(1); // control is qubit 3
+    state.apply(CNOTGate(), pair);
+    
+    EXPECT_EQ(3, state.factorsCount());
+    EXPECT_EQ(state.factorOf(1), state.factorOf(3));
+    EXPECT_NE(state.factorOf(0), state.factorOf(1));
+    EXPECT_EQ(4, state.factor(state.factorOf(1)).densityMatrix().rows());
+    
+    std::vector<uint> dims(4, 2);
+    VectorXcd expected = VectorXcd::Zero(16);
+    expected[0] = expected[5] = 1; // |0000> + |0101>
+    EXPECT_EQ(QuantumState(expected, HilbertSpace(dims)), state.toQuantumState());
+}
+
+TEST(ProductStateTest, TestMeasureAndPartialTrace) {
+    ProductState state(zeroQubits(3));
+    state.apply(HadamardGate(), 0);
+    std::vector<int> pair; pair.push_back(0); pair.push_back(2);
+    state.apply(CNOTGate(), pair);
+    
+    Measurement measure = Proector(HilbertSpace(2));
+    RandomGenerator gen(5);
+    int outcome = state.measure(measure, 2, gen);
+    EXPECT_EQ(outcome, state.measure(measure, 0, gen)); // Bell pair gives equal outcomes
+    
+    EXPECT_EQ(3, state.factorsCount()); // collapsed pair is split back
+    
+    ProductState traced = state.partialTrace(1);
+    EXPECT_EQ(2, traced.space().rank());
+    EXPECT_EQ(2, traced.factorsCount());
+    EXPECT_EQ(state.toQuantumState().partialTrace(1), traced.toQuantumState());
+    
+    ProductState single = traced.partialTrace(0);
+    EXPECT_EQ(1, single.factorsCount());
+    EXPECT_THROW(single.partialTrace(0), std::invalid_argument);
+}
+
+TEST(ProductStateTest, TestClustersSplitAfterMeasureAndReset) {
+    // syndrome extraction: ancilla 2 collects parity of data qubits 0 and 1, is measured and reset
+    ProductState state(zeroQubits(3));
+    state.apply(HadamardGate(), 0);
+    state.apply(HadamardGate(), 1);
+    std::vector<int> first; first.push_back(0); first.push_back(2);
+    std::vector<int> second; second.push_back(1); second.push_back(2);
+    Measurement measure = Proector(HilbertSpace(2));
+    RandomGenerator gen(11);
+    
+    for (int round = 0; round < 3; ++round) {
+	state.apply(CNOTGate(), first);
+	state.apply(CNOTGate(), second);
+	EXPECT_EQ(state.factorOf(0), state.factorOf(2));
+	
+	state.measure(measure, 2, gen);
+	EXPECT_EQ(1, state.factorSubsystems(state.factorOf(2)).size());
+	state.reset(2);
+	EXPECT_EQ(true, abs(state.factor(state.factorOf(2)).densityMatrix()(0, 0) - 1.0) < 1.0e-12);
+	EXPECT_EQ(4, state.factor(state.factorOf(0)).densityMatrix().rows());
+    }
+    
+    // Bell pair cannot be split, its half after reset of the other is mixed
+    ProductState bell(zeroQubits(2));
+    bell.apply(HadamardGate(), 0);
+    std::vector<int> pair; pair.push_back(0); pair.push_back(1);
+    bell.apply(CNOTGate(), pair);
+    EXPECT_EQ(false, bell.split(1));
+    bell.reset(0);
+    EXPECT_EQ(2, bell.factorsCount());
+    EXPECT_EQ(true, abs(bell.factor(bell.factorOf(1)).purity() - 0.5) < 1.0e-12);
+}
+
+TEST(ProductStateTest, TestWrongSizeGateIsRejectedBeforeMerge) {
+    ProductState state(zeroQubits(3));
+    std::vector<int> triple; triple.push_back(0); triple.push_back(1); triple.push_back(2);
+    // flat space of 4 does not match three qubits
+    UnitaryTransformation flat(MatrixXcd::Identity(4, 4), HilbertSpace(4));
+    EXPECT_THROW(state.apply(flat, triple), std::invalid_argument);
+    EXPECT_EQ(3, state.factorsCount());
+    
+    std::vector<uint> dims; dims.push_back(4); dims.push_back(2);
+    UnitaryTransformation wrongShape(MatrixXcd::Identity(8, 8), HilbertSpace(dims));
+    EXPECT_THROW(state.apply(wrongShape, triple), std::invalid_argument);
+    EXPECT_EQ(3, state.factorsCount());
+    
+    UnitaryTransformation flatRight(MatrixXcd::Identity(8, 8), HilbertSpace(8));
+    state.apply(flatRight, triple);
+    EXPECT_EQ(1, state.factorsCount());
+}
+
+TEST(ProductStateTest, TestMeasuredGHZFallsApart) {
+    ProductState ghz(zeroQubits(4));
+    ghz.apply(HadamardGate(), 0);
+    for (int q = 1; q < 4; ++q) {
+	std::vector<int> pair; pair.push_back(0); pair.push_back(q);
+	ghz.apply(CNOTGate(), pair);
+    }
+    EXPECT_EQ(1, ghz.factorsCount());
+    Measurement measure = Proector(HilbertSpace(2));
+    RandomGenerator gen(7);
+    int outcome = ghz.measure(measure, 1, gen);
+    EXPECT_EQ(4, ghz.factorsCount());
+    for (int q = 0; q < 4; ++q)
+	EXPECT_EQ(true, abs(ghz.factor(ghz.factorOf(q)).densityMatrix()(outcome, outcome) - 1.0) < 1.0e-12);
+    
+    // qubit 0 controls a gate on Bell pair 1-2: measuring it leaves the pair entangled
+    ProductState state(zeroQubits(3));
+    state.apply(HadamardGate(), 1);
+    std::vector<int> bell; bell.push_back(1); bell.push_back(2);
+    state.apply(CNOTGate(), bell);
+    state.apply(HadamardGate(), 0);
+    std::vector<int> control; control.push_back(0); control.push_back(1);
+    state.apply(CNOTGate(), control);
+    EXPECT_EQ(1, state.factorsCount());
+    state.measure(measure, 0, gen);
+    EXPECT_EQ(2, state.factorsCount());
+    EXPECT_EQ(state.factorOf(1), state.factorOf(2));
+}
+
+TEST(ProductStateTest, TestWideRegisterNeedsOnlyFactorSpaces) {
+    // 40 qubits have no HilbertSpace of their own, gates and measurement still work factor by factor
+    ProductState state(zeroQubits(40));
+    for (int q = 0; q < 40; ++q)
+	state.apply(HadamardGate(), q);
+    std::vector<int> pair; pair.push_back(39); pair.push_back(7);
+    state.apply(CNOTGate(), pair);
+    EXPECT_EQ(39, state.factorsCount());
+    EXPECT_THROW(state.space(), std::invalid_argument);
+    Measurement measure = Proector(HilbertSpace(2));
+    RandomGenerator gen(3);
+    state.measure(measure, 7, gen);
+    EXPECT_EQ(40, state.factorsCount());
+}
@@ -136,4 +136,78 @@ TEST(QST, TestPartTrace2) {
     QuantumState state(stateMatr, HilbertSpace::tensor(space, space));
     EXPECT_EQ(QuantumState(resMatr, space), state.partialTrace(0));
     EXPECT_EQ(QuantumState(resMatr, space), state.partialTrace(1));
-}
\ No newline at end of file
+}
+TEST(QST, TestMarginalProbabilities) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3); dims.push_back(2);
+    HilbertSpace space(dims);
+    VectorXcd vec(12);
+    for (int i = 0; i < 12; ++i) vec[i] = i + 1;
+    QuantumState state(vec, space);
+    double norm = vec.squaredNorm();
+    
+    std::vector< std::vector<int> > subsets(3);
+    subsets[0].push_back(1);
+    subsets[1].push_back(2); subsets[1].push_back(0); // outcome index is 2 * q2 + q0
+    // subsets[2] is empty: total probability
+    
+    std::vector< std::vector<double> > res = state.marginalProbabilities(subsets);
+    ASSERT_EQ(3, res.size());
+    ASSERT_EQ(3, res[0].size());
+    ASSERT_EQ(4, res[1].size());
+    ASSERT_EQ(1, res[2].size());
+    
+    for (int q1 = 0; q1 < 3; ++q1) {
+	double expected = 0;
+	for (int q0 = 0; q0 < 2; ++q0)
+	    for (int q2 = 0; q2 < 2; ++q2)
+		expected += pow(q0 * 6 + q1 * 2 + q2 + 1, 2) / norm;
+	EXPECT_EQ(true, abs(expected - res[0][q1]) < 1.0e-12);
+    }
+    double expected = 0;
+    for (int q1 = 0; q1 < 3; ++q1) expected += pow(1 * 6 + q1 * 2 + 0 + 1, 2) / norm; // q2 = 0, q0 = 1
+    EXPECT_EQ(true, abs(expected - res[1][1]) < 1.0e-12);
+    EXPECT_EQ(true, abs(1 - res[2][0]) < 1.0e-12);
+    
+    std::vector< std::vector<double> > fromVector = QuantumState::marginalProbabilities(vec, space, subsets);
+    for (int s = 0; s < 3; ++s)
+	for (int k = 0; k < res[s].size(); ++k)
+	    EXPECT_EQ(true, abs(fromVector[s][k] - res[s][k]) < 1.0e-12);
+    
+    subsets[0].push_back(1);
+    EXPECT_ANY_THROW(state.marginalProbabilities(subsets));
+}
+
+TEST(QST, TestPermuteSubsystems) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3);
+    VectorXcd first(2), second(3);
+    first << 1, 2;
+    second << 0, 1, 3;
+    QuantumState state = QuantumState::tensor(QuantumState(first, HilbertSpace(2)), QuantumState(second, HilbertSpace(3)));
+    
+    std::vector<int> perm; perm.push_back(1); perm.push_back(0);
+    state.permuteSubsystems(perm);
+    EXPECT_EQ(3, state.space().dimension(0));
+    EXPECT_EQ(QuantumState::tensor(QuantumState(second, HilbertSpace(3)), QuantumState(first, HilbertSpace(2))), state);
+}
+
+TEST(QST, TestSetMatrixToleratesAccumulatedRounding) {
+    QuantumState state(Vector2cd(1, 0), HilbertSpace(2));
+    Matrix2cd rounded = Matrix2cd::Zero();
+    rounded(0, 0) = 0.5 + 3.0e-13; // a few hundred gates worth of rounding
+    rounded(1, 1) = 0.5;
+    EXPECT_NO_THROW(state.setMatrix(rounded));
+    
+    // many gates in a row, each one rounds the trace slightly
+    Matrix2cd rotation;
+    rotation << cos(0.3), -sin(0.3), sin(0.3), cos(0.3);
+    MatrixXcd density = state.densityMatrix();
+    for (int i = 0; i < 1000; ++i) {
+	density = rotation * density * rotation.adjoint();
+	EXPECT_NO_THROW(state.setMatrix(density));
+    }
+    
+    Matrix2cd wrong = Matrix2cd::Zero();
+    wrong(0, 0) = 0.5 + 1.0e-8;
+    wrong(1, 1) = 0.5;
+    EXPECT_ANY_THROW(state.setMatrix(wrong));
+}
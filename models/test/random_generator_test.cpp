@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "../random_generator.h"
+#include "../measurement.h"
+
+TEST(RandomGeneratorTest, TestSameSeedGivesSameSequence) {
+    RandomGenerator first(42), second(42), other(43);
+    bool differs = false;
+    for (int i = 0; i < 100; ++i) {
+	uint64_t value = first.next();
+	EXPECT_EQ(value, second.next());
+	if (value != other.next()) differs = true;
+    }
+    EXPECT_EQ(true, differs);
+}
+
+TEST(RandomGeneratorTest, TestUniformIsInUnitInterval) {
+    RandomGenerator gen(7);
+    double sum = 0;
+    for (int i = 0; i < 10000; ++i) {
+	double r = gen.uniform();
+	EXPECT_EQ(true, r >= 0 && r < 1);
+	sum += r;
+    }
+    EXPECT_EQ(true, abs(sum / 10000 - 0.5) < 0.02);
+}
+
+TEST(RandomGeneratorTest, TestDiscardIsTheSameAsDrawing) {
+    for (int skip = 0; skip < 7; ++skip) {
+	RandomGenerator drawn(5), jumped(5);
+	drawn.next(); jumped.next(); // start from the middle of block
+	for (int i = 0; i < skip; ++i) drawn.next();
+	jumped.discard(skip);
+	EXPECT_EQ(drawn.next(), jumped.next());
+    }
+}
+
+TEST(RandomGeneratorTest, TestSplitDoesNotDependOnDrawnNumbers) {
+    RandomGenerator parent(11), used(11);
+    for (int i = 0; i < 13; ++i) used.next();
+    
+    RandomGenerator child1 = parent.split(3), child2 = used.split(3), child3 = parent.split(4);
+    EXPECT_EQ(parent.seed(), child1.seed());
+    EXPECT_EQ(child1.stream(), child2.stream());
+    EXPECT_EQ(child1.next(), child2.next());
+    EXPECT_NE(child1.stream(), child3.stream());
+}
+
+TEST(RandomGeneratorTest, TestMeasurementIsReproducible) {
+    Measurement measure = Proector(HilbertSpace(2));
+    RandomGenerator gen(2013);
+    std::vector<std::string> outcomes;
+    for (int shot = 0; shot < 20; ++shot) {
+	QuantumState state(Vector2cd(1,1), HilbertSpace(2));
+	RandomGenerator shotGen = gen.split(shot);
+	outcomes.push_back(measure.performOn(&state, shotGen));
+    }
+    
+    for (int shot = 19; shot >= 0; --shot) { // order of shots does not matter
+	QuantumState state(Vector2cd(1,1), HilbertSpace(2));
+	RandomGenerator shotGen = gen.split(shot);
+	EXPECT_EQ(outcomes[shot], measure.performOn(&state, shotGen));
+    }
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "../schmidt_decomposition.h"
+#include "../state_metrics.h"
+#include "../kronecker_tensor.h"
+
+TEST(SchmidtDecompositionTest, TestProductAndBellStates) {
+    std::vector<uint> dims(2, 2);
+    HilbertSpace space(dims);
+    std::vector<int> first(1, 0);
+    
+    SchmidtDecomposition product(Vector4cd(1, 1, 0, 0), space, first);
+    EXPECT_EQ(true, abs(1 - product.coefficients()[0]) < 1.0e-12);
+    EXPECT_EQ(true, abs(product.entropy()) < 1.0e-12);
+    
+    SchmidtDecomposition bell(Vector4cd(1, 0, 0, 1), space, first, 1.0e-12);
+    EXPECT_EQ(2, bell.rank());
+    EXPECT_EQ(true, abs(1 - bell.entropy()) < 1.0e-12);
+    
+    SchmidtDecomposition truncated(Vector4cd(1, 1, 0, 0), space, first, 1.0e-12);
+    EXPECT_EQ(1, truncated.rank());
+    EXPECT_EQ(true, truncated.truncationError() < 1.0e-20);
+}
+
+TEST(SchmidtDecompositionTest, TestReconstructionWithReorderedSubsystems) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3); dims.push_back(2);
+    HilbertSpace space(dims);
+    VectorXcd vec = VectorXcd::Random(12); vec.normalize();
+    std::vector<int> partA; partA.push_back(2); partA.push_back(0); // A = |q2 q0>, B = |q1>
+    
+    SchmidtDecomposition decomposition(vec, space, partA);
+    EXPECT_EQ(true, abs(1 - decomposition.coefficients().squaredNorm()) < 1.0e-12);
+    
+    VectorXcd restored = VectorXcd::Zero(12);
+    for (int k = 0; k < decomposition.rank(); ++k) {
+	VectorXcd a = decomposition.basisA().col(k), b = decomposition.basisB().col(k);
+	for (int q0 = 0; q0 < 2; ++q0)
+	    for (int q1 = 0; q1 < 3; ++q1)
+		for (int q2 = 0; q2 < 2; ++q2)
+		    restored[q0 * 6 + q1 * 2 + q2] += decomposition.coefficients()[k] * a[q2 * 2 + q0] * b[q1];
+    }
+    EXPECT_EQ(true, vec.isApprox(restored));
+}
+
+TEST(SchmidtDecompositionTest, TestEntropyMatchesReducedState) {
+    std::vector<uint> dims(3, 2);
+    HilbertSpace space(dims);
+    VectorXcd vec = VectorXcd::Random(8); vec.normalize();
+    QuantumState state(vec, space);
+    
+    std::vector<int> partA; partA.push_back(0); partA.push_back(1);
+    QuantumState reduced = state.partialTrace(2);
+    
+    EXPECT_EQ(true, abs(StateMetrics::vonNeumannEntropy(reduced) - StateMetrics::entanglementEntropy(vec, space, partA)) < 1.0e-10);
+    EXPECT_EQ(true, abs(StateMetrics::vonNeumannEntropy(reduced) - StateMetrics::entanglementEntropy(state, partA)) < 1.0e-10);
+}
+
+TEST(SchmidtDecompositionTest, TestPureStateMatchesVector) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3); dims.push_back(2);
+    HilbertSpace space(dims);
+    VectorXcd vec = VectorXcd::Zero(12);
+    vec[1] = std::complex<double>(0, 0.6); vec[10] = -0.8;
+    std::vector<int> partA(1, 1);
+    SchmidtDecomposition fromVector(vec, space, partA), fromState(QuantumState(vec, space), partA);
+    EXPECT_EQ(true, fromVector.coefficients().isApprox(fromState.coefficients()));
+    EXPECT_EQ(2, fromState.rank());
+    EXPECT_THROW(SchmidtDecomposition(QuantumState(MatrixXcd::Identity(12, 12) / 12, space), partA), std::invalid_argument);
+}
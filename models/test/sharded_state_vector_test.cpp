@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include "../sharded_state_vector.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+#include "../transforms/toffoligate.h"
+#include <chrono>
+#include <thread>
+#include <signal.h>
+#include <sys/wait.h>
+
+namespace {
+std::vector<int> list(int a, int b, int c = -1)
+{
+    std::vector<int> res; res.push_back(a); res.push_back(b);
+    if (c >= 0) res.push_back(c);
+    return res;
+}
+}
+
+TEST(ShardedStateVectorTest, TestMatchesInMemoryVector) {
+    // 14 qubits on 4 workers: half shard is 2^14 / 4 / 2 = 2048 amplitudes, eight exchange blocks of 256, so packing
+    // and unpacking of blocks overlap
+    Circuit circuit(HilbertSpace(std::vector<uint>(14, 2)));
+    for (int layer = 0; layer < 2; ++layer) {
+	for (int q = 0; q < 14; ++q) {
+	    circuit.addGate(HadamardGate(), q);
+	    circuit.addGate(PhaseShiftGate(0.2 * q + layer), q);
+	}
+	for (int q = layer % 2; q + 1 < 14; q += 2)
+	    circuit.addGate(CNOTGate(), list(q, q + 1));
+    }
+    circuit.addGate(ToffoliGate(), list(0, 1, 13));
+    VectorXcd vec = VectorXcd::Zero(1 << 14);
+    vec[0] = 1;
+    circuit.applyTo(vec);
+    
+    ShardedStateVector sharded(circuit.space(), 4, 256);
+    sharded.apply(circuit);
+    EXPECT_EQ(true, vec.isApprox(sharded.toVector()));
+    EXPECT_EQ(true, sharded.exchangesCount() > 0);
+    EXPECT_EQ(true, abs(vec[(1 << 14) - 1] - sharded.amplitude(std::vector<int>(14, 1))) < 1.0e-12);
+}
+
+TEST(ShardedStateVectorTest, TestGateRoutesToWorkers) {
+    HilbertSpace space(std::vector<uint>(3, 2));
+    ShardedStateVector sharded(space, 2);
+    HadamardGate().applyTo(&sharded, std::vector<int>(1, 0)); // global qubit
+    CNOTGate().applyTo(&sharded, list(0, 2));
+    
+    VectorXcd expected = VectorXcd::Zero(8);
+    expected[0] = expected[5] = 1 / sqrt(2.0);
+    EXPECT_EQ(true, expected.isApprox(sharded.toVector()));
+    EXPECT_EQ(1, sharded.exchangesCount());
+    
+    EXPECT_THROW(ShardedStateVector(space, 3), std::invalid_argument);
+    EXPECT_THROW(ShardedStateVector(space, 8), std::invalid_argument);
+    EXPECT_THROW(sharded.apply(ToffoliGate(), list(0, 1, 2)), std::invalid_argument);
+}
+
+TEST(ShardedStateVectorTest, TestLostWorkerIsReported) {
+    // worker 1 is gone: the gate on the global qubit must not hang its partner nor kill the caller by SIGPIPE
+    HilbertSpace space(std::vector<uint>(4, 2));
+    ShardedStateVector sharded(space, 2, 2);
+    HadamardGate().applyTo(&sharded, std::vector<int>(1, 3));
+    kill(sharded.workerPid(1), SIGKILL);
+    waitpid(sharded.workerPid(1), 0, 0);
+    EXPECT_THROW(HadamardGate().applyTo(&sharded, std::vector<int>(1, 0)), std::runtime_error);
+    EXPECT_THROW(HadamardGate().applyTo(&sharded, std::vector<int>(1, 3)), std::runtime_error);
+}
+
+TEST(ShardedStateVectorTest, TestWorkerLostDuringExchange) {
+    // worker 1 is stopped, so worker 0 waits for its blocks in exchange; then worker 1 dies
+    HilbertSpace space(std::vector<uint>(4, 2));
+    ShardedStateVector sharded(space, 2, 2);
+    kill(sharded.workerPid(1), SIGSTOP);
+    bool thrown = false;
+    std::thread caller([&]() {
+	try {
+	    HadamardGate().applyTo(&sharded, std::vector<int>(1, 0));
+	}
+	catch (const std::runtime_error&) {
+	    thrown = true;
+	}
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    kill(sharded.workerPid(1), SIGKILL);
+    caller.join();
+    EXPECT_EQ(true, thrown);
+}
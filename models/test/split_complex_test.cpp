@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "../split_complex.h"
+#include "../kronecker_tensor.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+#include "../transforms/pauligate.h"
+
+namespace {
+std::vector<int> pair(int a, int b)
+{
+    std::vector<int> res; res.push_back(a); res.push_back(b);
+    return res;
+}
+}
+
+TEST(SplitComplexTest, TestVectorMatchesInterleaved) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3); dims.push_back(2);
+    VectorXcd vec = VectorXcd::Random(12);
+    vec.normalize();
+    SplitStateVector split(vec, HilbertSpace(dims));
+    EXPECT_EQ(vec, split.toInterleaved());
+    
+    MatrixXcd qutrit = MatrixXcd::Identity(3, 3);
+    qutrit.bottomRightCorner(2, 2) = HadamardGate().transformMatrix();
+    MatrixXcd target = vec;
+    KroneckerTensor::applyToSubsystem(qutrit, 1, dims, target);
+    KroneckerTensor::applyToSubsystems(CNOTGate().transformMatrix(), pair(2, 0), dims, target);
+    split.apply(qutrit, std::vector<int>(1, 1));
+    split.apply(CNOTGate().transformMatrix(), pair(2, 0));
+    // qubit gates with complex entries go through the butterfly
+    MatrixXcd phased = PhaseShiftGate(0.3).transformMatrix() * HadamardGate().transformMatrix();
+    for (int q = 0; q < 3; q += 2) {
+	KroneckerTensor::applyToSubsystem(phased, q, dims, target);
+	split.apply(phased, std::vector<int>(1, q));
+    }
+    EXPECT_EQ(true, target.col(0).isApprox(split.toInterleaved()));
+    EXPECT_THROW(split.apply(CNOTGate().transformMatrix(), pair(2, 2)), std::invalid_argument);
+    EXPECT_EQ(true, split.probabilities().isApprox(target.col(0).cwiseAbs2()));
+    
+    MatrixXcd z = PauliGate(PauliGate::Z).transformMatrix();
+    double expected = target.col(0).head(6).squaredNorm() - target.col(0).tail(6).squaredNorm();
+    EXPECT_EQ(true, abs(split.expectation(z, std::vector<int>(1, 0)) - expected) < 1.0e-12);
+}
+
+TEST(SplitComplexTest, TestDensityMatchesInterleaved) {
+    std::vector<uint> dims(3, 2);
+    HilbertSpace space(dims);
+    MatrixXcd a = MatrixXcd::Random(8, 8);
+    MatrixXcd density = a * a.adjoint();
+    density /= density.trace();
+    
+    SplitDensityMatrix split(density, space);
+    MatrixXcd phase = PhaseShiftGate(0.7).transformMatrix();
+    MatrixXcd expanded = KroneckerTensor::expand(phase, 1, dims);
+    split.apply(phase, std::vector<int>(1, 1));
+    split.apply(CNOTGate().transformMatrix(), pair(1, 2));
+    MatrixXcd cnot = KroneckerTensor::product(KroneckerTensor::getIdentityMatrix(2), CNOTGate().transformMatrix());
+    MatrixXcd expected = cnot * expanded * density * expanded.adjoint() * cnot.adjoint();
+    EXPECT_EQ(true, expected.isApprox(split.toInterleaved()));
+    EXPECT_EQ(true, split.probabilities().isApprox(expected.diagonal().real()));
+    
+    MatrixXcd x = PauliGate(PauliGate::X).transformMatrix();
+    std::complex<double> trace = (expected * KroneckerTensor::expand(x, 2, dims)).trace();
+    EXPECT_EQ(true, abs(split.expectation(x, std::vector<int>(1, 2)) - trace.real()) < 1.0e-12);
+}
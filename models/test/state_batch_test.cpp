@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include "../state_batch.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+#include "../transforms/toffoligate.h"
+#include "../transforms/swapgate.h"
+
+namespace {
+std::vector<int> list(int a, int b, int c = -1)
+{
+    std::vector<int> res; res.push_back(a); res.push_back(b);
+    if (c >= 0) res.push_back(c);
+    return res;
+}
+}
+
+TEST(StateBatchTest, TestMatchesSingleStates) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3); dims.push_back(2); dims.push_back(2);
+    HilbertSpace space(dims);
+    Circuit circuit(space);
+    circuit.addGate(HadamardGate(), 0);
+    circuit.addGate(HadamardGate(), 3); // last subsystem, one product for the batch
+    circuit.addGate(CNOTGate(), list(3, 2)); // adjacent in reversed order
+    circuit.addGate(CNOTGate(), list(0, 3)); // not adjacent
+    circuit.addGate(PhaseShiftGate(0.5), 2);
+    MatrixXcd qutrit = MatrixXcd::Identity(3, 3);
+    qutrit.topLeftCorner(2, 2) = HadamardGate().transformMatrix();
+    circuit.addGate(UnitaryTransformation(qutrit, HilbertSpace(3)), 1); // middle subsystem, strided slices
+    
+    MatrixXcd inputs = MatrixXcd::Random(24, 5);
+    StateBatch batch(space, inputs);
+    batch.apply(circuit);
+    for (int b = 0; b < 5; ++b) {
+	VectorXcd vec = inputs.col(b);
+	circuit.applyTo(vec);
+	EXPECT_EQ(true, vec.isApprox(batch.state(b)));
+    }
+}
+
+TEST(StateBatchTest, TestBasisInputsGiveCircuitMatrix) {
+    HilbertSpace space(std::vector<uint>(3, 2));
+    Circuit circuit(space);
+    circuit.addGate(ToffoliGate(), list(0, 1, 2));
+    circuit.addGate(SwapGate(), list(1, 2));
+    StateBatch batch = StateBatch::basisInputs(space);
+    batch.apply(circuit);
+    EXPECT_EQ(8, batch.size());
+    
+    // |110> -> Toffoli |111> -> swap |111>; |101> -> |101> -> |110>
+    EXPECT_EQ(std::complex<double>(1), batch.states()(7, 6));
+    EXPECT_EQ(std::complex<double>(1), batch.states()(6, 5));
+    MatrixXcd gram = batch.states().adjoint() * batch.states();
+    EXPECT_EQ(true, gram.isIdentity());
+    
+    StateBatch zeros(space, 3);
+    EXPECT_EQ(std::complex<double>(1), zeros.state(2)[0]);
+    EXPECT_THROW(zeros.apply(MatrixXcd::Identity(2, 2), list(0, 1)), std::invalid_argument);
+}
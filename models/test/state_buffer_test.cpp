@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "../state_buffer.h"
+#include "../circuit.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+
+TEST(StateBufferTest, TestRangesAndFirstTouch) {
+    StateBuffer buffer(1 << 16, StateBuffer::Interleave, 3, false);
+    EXPECT_EQ(3, buffer.threadsCount());
+    EXPECT_EQ(true, buffer.nodesCount() >= 1);
+    std::vector<long long> ranges = buffer.ranges();
+    EXPECT_EQ(0, ranges.front());
+    EXPECT_EQ(1 << 16, ranges.back());
+    EXPECT_EQ(true, buffer.vector().isZero());
+    
+    // every amplitude is visited by exactly one worker
+    buffer.parallelFor([&buffer](int thread, long long begin, long long end) {
+	for (long long i = begin; i < end; ++i)
+	    buffer.data()[i] += thread + 1.0;
+    });
+    for (int t = 0; t < 3; ++t)
+	for (long long i = ranges[t]; i < ranges[t + 1]; ++i)
+	    EXPECT_EQ(std::complex<double>(t + 1.0), buffer.data()[i]);
+    EXPECT_THROW(StateBuffer(0), std::invalid_argument);
+}
+
+TEST(StateBufferTest, TestApplyMatchesCircuit) {
+    std::vector<uint> dims(12, 2);
+    Circuit circuit((HilbertSpace(dims)));
+    for (int q = 0; q < 12; ++q) {
+	circuit.addGate(HadamardGate(), q);
+	circuit.addGate(PhaseShiftGate(0.1 * q), q);
+    }
+    std::vector<int> pair; pair.push_back(0); pair.push_back(11);
+    circuit.addGate(CNOTGate(), pair);
+    VectorXcd vec = VectorXcd::Zero(1 << 12);
+    vec[0] = 1;
+    circuit.applyTo(vec);
+    
+    // small pages, so all four ranges are used and gates on the leading qubit cross them
+    StateBuffer buffer(1 << 12, StateBuffer::Partition, 4, false);
+    for (int t = 0; t < 4; ++t)
+	EXPECT_EQ(true, buffer.ranges()[t + 1] > buffer.ranges()[t]);
+    buffer.data()[0] = 1;
+    for (int g = 0; g < circuit.gatesCount(); ++g)
+	buffer.apply(circuit.gate(g).matrix, circuit.gate(g).subsystems, dims);
+    EXPECT_EQ(true, vec.isApprox(buffer.vector()));
+    EXPECT_THROW(buffer.apply(circuit.gate(circuit.gatesCount() - 1).matrix, std::vector<int>(2, 11), dims), std::invalid_argument);
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include "../state_metrics.h"
+
+TEST(StateMetricsTest, TestPurityAndEntropies) {
+    QuantumState pure(Vector2cd(1, 1), HilbertSpace(2));
+    Matrix2cd mixedMatr; mixedMatr << 0.5, 0, 0, 0.5;
+    QuantumState mixed(mixedMatr, HilbertSpace(2));
+    
+    EXPECT_EQ(true, abs(1 - StateMetrics::purity(pure)) < 1.0e-12);
+    EXPECT_EQ(true, abs(0.5 - StateMetrics::purity(mixed)) < 1.0e-12);
+    EXPECT_EQ(true, abs(StateMetrics::vonNeumannEntropy(pure)) < 1.0e-12);
+    EXPECT_EQ(true, abs(1 - StateMetrics::vonNeumannEntropy(mixed)) < 1.0e-12);
+    EXPECT_EQ(true, abs(1 - StateMetrics::renyi2Entropy(mixed)) < 1.0e-12);
+}
+
+TEST(StateMetricsTest, TestFidelity) {
+    Vector2cd zero(1, 0), plus(1, 1);
+    plus.normalize();
+    QuantumState zeroState(zero, HilbertSpace(2)), plusState(plus, HilbertSpace(2));
+    Matrix2cd mixedMatr; mixedMatr << 0.75, 0, 0, 0.25;
+    QuantumState mixed(mixedMatr, HilbertSpace(2));
+    Matrix2cd otherMatr; otherMatr << 0.5, 0.25, 0.25, 0.5;
+    QuantumState other(otherMatr, HilbertSpace(2));
+    
+    EXPECT_EQ(true, abs(0.5 - StateMetrics::fidelity(zero, plus)) < 1.0e-12);
+    EXPECT_EQ(true, abs(0.5 - StateMetrics::fidelity(zero, plusState)) < 1.0e-12);
+    EXPECT_EQ(true, abs(0.5 - StateMetrics::fidelity(zeroState, plusState)) < 1.0e-12);
+    EXPECT_EQ(true, abs(0.75 - StateMetrics::fidelity(zeroState, mixed)) < 1.0e-12);
+    
+    // two mixed states: F = (Tr sqrt(sqrt(p) s sqrt(p)))^2
+    double f = StateMetrics::fidelity(mixed, other);
+    EXPECT_EQ(true, abs(f - StateMetrics::fidelity(other, mixed)) < 1.0e-12);
+    EXPECT_EQ(true, abs(0.875 - f) < 1.0e-12); // eigen values of sqrt(p) s sqrt(p) are 1/4 +- sqrt(7)/16
+    EXPECT_EQ(true, abs(1 - StateMetrics::fidelity(mixed, mixed)) < 1.0e-12);
+}
+
+TEST(StateMetricsTest, TestTraceDistance) {
+    Vector2cd zero(1, 0), one(0, 1), plus(1, 1);
+    QuantumState zeroState(zero, HilbertSpace(2)), oneState(one, HilbertSpace(2));
+    Matrix2cd mixedMatr; mixedMatr << 0.5, 0, 0, 0.5;
+    QuantumState mixed(mixedMatr, HilbertSpace(2));
+    
+    EXPECT_EQ(true, abs(1 - StateMetrics::traceDistance(zero, one)) < 1.0e-12);
+    EXPECT_EQ(true, abs(1 - StateMetrics::traceDistance(zeroState, oneState)) < 1.0e-12);
+    EXPECT_EQ(true, abs(sqrt(0.5) - StateMetrics::traceDistance(zero, plus)) < 1.0e-12);
+    EXPECT_EQ(true, abs(0.5 - StateMetrics::traceDistance(zero, mixed)) < 1.0e-12);
+    EXPECT_EQ(true, abs(0.5 - StateMetrics::traceDistance(zeroState, mixed)) < 1.0e-12);
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "../tensor_network.h"
+#include "../kronecker_tensor.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+#include "../transforms/pauligate.h"
+
+namespace {
+std::vector<int> pair(int a, int b)
+{
+    std::vector<int> res; res.push_back(a); res.push_back(b);
+    return res;
+}
+
+// layers of H, phase shifts and CNOT ladder
+Circuit layeredCircuit(int qubits, int depth)
+{
+    Circuit circuit((std::vector<uint>(qubits, 2)));
+    for (int layer = 0; layer < depth; ++layer) {
+	for (int q = 0; q < qubits; ++q) {
+	    circuit.addGate(HadamardGate(), q);
+	    circuit.addGate(PhaseShiftGate(0.3 * (q + 1) + layer), q);
+	}
+	for (int q = layer % 2; q + 1 < qubits; q += 2)
+	    circuit.addGate(CNOTGate(), pair(q, q + 1));
+    }
+    return circuit;
+}
+}
+
+TEST(TensorNetworkTest, TestContractPair) {
+    TensorNetwork network;
+    int i = network.newIndex(2), j = network.newIndex(3), k = network.newIndex(2);
+    MatrixXcd a = MatrixXcd::Random(2, 3), b = MatrixXcd::Random(3, 2);
+    VectorXcd dataA(6), dataB(6);
+    for (int r = 0; r < 2; ++r)
+	for (int c = 0; c < 3; ++c) {
+	    dataA[r * 3 + c] = a(r, c);
+	    dataB[c * 2 + r] = b(c, r);
+	}
+    network.addTensor(dataA, pair(i, j));
+    network.addTensor(dataB, pair(j, k));
+    
+    NetworkTensor res = network.contract(pair(k, i)); // transposed product
+    MatrixXcd product = a * b;
+    for (int r = 0; r < 2; ++r)
+	for (int c = 0; c < 2; ++c)
+	    EXPECT_EQ(true, abs(res.data[c * 2 + r] - product(r, c)) < 1.0e-12);
+}
+
+TEST(TensorNetworkTest, TestAmplitudesMatchStateVector) {
+    Circuit circuit = layeredCircuit(5, 3);
+    VectorXcd vec = VectorXcd::Zero(32);
+    vec[0] = 1;
+    circuit.applyTo(vec);
+    
+    std::vector<int> outcome(5, 0);
+    outcome[0] = 1; outcome[3] = 1; // 10010
+    EXPECT_EQ(true, abs(vec[18] - TensorNetwork::amplitude(circuit, outcome)) < 1.0e-12);
+    
+    std::vector<int> open = pair(4, 1); // amplitudes 1x0x1, last qubit is the most significant
+    VectorXcd batch = TensorNetwork::amplitudes(circuit, outcome, open);
+    for (int a = 0; a < 2; ++a)
+	for (int b = 0; b < 2; ++b)
+	    EXPECT_EQ(true, abs(vec[16 + 8 * b + 2 + a] - batch[a * 2 + b]) < 1.0e-12);
+}
+
+TEST(TensorNetworkTest, TestExpectationMatchesDensity) {
+    Circuit circuit = layeredCircuit(4, 4);
+    QuantumState state(VectorXcd::Unit(16, 0), HilbertSpace(std::vector<uint>(4, 2)));
+    circuit.applyTo(&state);
+    
+    Matrix4cd zz = KroneckerTensor::product(PauliGate(PauliGate::Z).transformMatrix(), PauliGate(PauliGate::X).transformMatrix());
+    MatrixXcd expanded = KroneckerTensor::product(KroneckerTensor::product(KroneckerTensor::getIdentityMatrix(2), zz), KroneckerTensor::getIdentityMatrix(2));
+    std::complex<double> expected = (state.densityMatrix() * expanded).trace();
+    EXPECT_EQ(true, abs(expected - TensorNetwork::expectation(circuit, zz, pair(1, 2))) < 1.0e-12);
+}
+
+TEST(TensorNetworkTest, TestWideShallowCircuit) {
+    // 48 qubits: H on all, then CZ-like phases do not change amplitude of |0...0>
+    // 2^48 states do not fit in int, so the circuit is described by dimensions only and has no HilbertSpace
+    Circuit circuit((std::vector<uint>(48, 2)));
+    EXPECT_EQ(48, circuit.rank());
+    EXPECT_THROW(circuit.space(), std::invalid_argument);
+    for (int q = 0; q < 48; ++q)
+	circuit.addGate(HadamardGate(), q);
+    for (int q = 0; q + 1 < 48; ++q)
+	circuit.addGate(CNOTGate(), pair(q, q + 1));
+    EXPECT_EQ(true, abs(TensorNetwork::amplitude(circuit, std::vector<int>(48, 0)) - pow(2.0, -24)) < 1.0e-15);
+    
+    // light cone of qubit 0 after 2 layers is the same in 60-qubit circuit and 6-qubit one, which fits in memory
+    Circuit wide = layeredCircuit(60, 2), narrow = layeredCircuit(6, 2);
+    VectorXcd vec = VectorXcd::Zero(64);
+    vec[0] = 1;
+    narrow.applyTo(vec);
+    double expected = vec.head(32).squaredNorm() - vec.tail(32).squaredNorm();
+    Matrix2cd z = PauliGate(PauliGate::Z).transformMatrix();
+    EXPECT_EQ(true, abs(TensorNetwork::expectation(wide, z, std::vector<int>(1, 0)) - expected) < 1.0e-12);
+    
+    TensorNetwork network;
+    std::vector<int> wires;
+    for (int i = 0; i < 3; ++i) wires.push_back(network.newIndex(2));
+    network.addTensor(VectorXcd::Ones(4), pair(wires[0], wires[1]));
+    network.addTensor(VectorXcd::Ones(4), pair(wires[1], wires[2]));
+    network.addTensor(VectorXcd::Ones(2), std::vector<int>(1, wires[2]));
+    ContractionPath path = network.optimizeOrder(8, 1);
+    EXPECT_EQ(2, path.steps.size());
+    EXPECT_EQ(true, path.flops <= 8 + 4);
+    EXPECT_EQ(true, abs(network.contract(path, std::vector<int>(1, wires[0])).data[0] - 4.0) < 1.0e-12);
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "../vectorized_density_matrix.h"
+#include "../kronecker_tensor.h"
+#include "../transforms/hadamardgate.h"
+#include "../transforms/controlledugate.h"
+#include "../transforms/phaseshiftgate.h"
+#include "../transforms/pauligate.h"
+
+TEST(VectorizedDensityMatrixTest, TestMatchesDenseEvolution) {
+    std::vector<uint> dims; dims.push_back(2); dims.push_back(3); dims.push_back(2);
+    HilbertSpace space(dims);
+    MatrixXcd a = MatrixXcd::Random(12, 12);
+    MatrixXcd density = a * a.adjoint();
+    density /= density.trace();
+    
+    VectorizedDensityMatrix state(density, space);
+    EXPECT_EQ(true, state.densityMatrix().isApprox(density));
+    EXPECT_EQ(144, state.superSpace().totalDimension());
+    
+    std::vector<int> pair; pair.push_back(2); pair.push_back(0);
+    MatrixXcd qutrit = MatrixXcd::Identity(3, 3);
+    qutrit.bottomRightCorner(2, 2) = PhaseShiftGate(0.9).transformMatrix() * HadamardGate().transformMatrix();
+    state.apply(qutrit, std::vector<int>(1, 1));
+    CNOTGate().applyTo(&state, pair);
+    MatrixXcd u1 = KroneckerTensor::expand(qutrit, 1, dims);
+    MatrixXcd cnot = MatrixXcd::Identity(12, 12);
+    KroneckerTensor::applyToSubsystems(CNOTGate().transformMatrix(), pair, dims, cnot);
+    density = cnot * u1 * density * u1.adjoint() * cnot.adjoint();
+    EXPECT_EQ(true, state.densityMatrix().isApprox(density));
+    
+    // amplitude damping on qubit 2
+    double gamma = 0.25;
+    std::vector<MatrixXcd> kraus(2, MatrixXcd::Zero(2, 2));
+    kraus[0](0, 0) = 1; kraus[0](1, 1) = sqrt(1 - gamma);
+    kraus[1](0, 1) = sqrt(gamma);
+    state.applyChannel(kraus, std::vector<int>(1, 2));
+    MatrixXcd damped = MatrixXcd::Zero(12, 12);
+    for (int i = 0; i < 2; ++i) {
+	MatrixXcd k = KroneckerTensor::expand(kraus[i], 2, dims);
+	damped += k * density * k.adjoint();
+    }
+    EXPECT_EQ(true, state.densityMatrix().isApprox(damped));
+    EXPECT_EQ(true, state.probabilities().isApprox(damped.diagonal().real()));
+    EXPECT_EQ(true, abs(state.purity() - (damped * damped).trace().real()) < 1.0e-12);
+    MatrixXcd x = PauliGate(PauliGate::X).transformMatrix();
+    std::complex<double> expected = (KroneckerTensor::expand(x, 0, dims) * damped).trace();
+    EXPECT_EQ(true, abs(state.expectation(x, std::vector<int>(1, 0)) - expected) < 1.0e-12);
+    
+    RandomGenerator gen(2);
+    int outcome = state.measure(1, gen);
+    VectorXd probs = state.probabilities();
+    EXPECT_EQ(true, abs(probs.sum() - 1) < 1.0e-12);
+    for (int i = 0; i < 12; ++i)
+	if ((i / 2) % 3 != outcome) {
+	    EXPECT_EQ(0, probs[i]);
+	}
+    EXPECT_EQ(true, state.toQuantumState().space() == space);
+}
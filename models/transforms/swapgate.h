@@ -30,7 +30,8 @@
 #include "../unitary_transformation.h"
 
 /**
- * The swap gate swaps two qubits
+ * The swap gate swaps two qubits. KroneckerTensor::applyToSubsystems() recognises its matrix and moves amplitudes
+ * in place with KroneckerTensor::swapSubsystems() instead of multiplying
  */
 class SwapGate : public UnitaryTransformation
 {
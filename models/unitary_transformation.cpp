@@ -26,6 +26,8 @@
 
 #include "unitary_transformation.h"
 #include "kronecker_tensor.h"
+#include "sharded_state_vector.h"
+#include "vectorized_density_matrix.h"
 #include "../Eigen/LU"
 #include <stdexcept>
 
@@ -115,14 +117,26 @@ QuantumState* UnitaryTransformation::applyTo(QuantumState* state)
     return state;
 }
 
+ShardedStateVector* UnitaryTransformation::applyTo(ShardedStateVector* state, const std::vector< int >& subsystems) const
+{
+    state->apply(*this, subsystems);
+    return state;
+}
+
+VectorizedDensityMatrix* UnitaryTransformation::applyTo(VectorizedDensityMatrix* state, const std::vector< int >& subsystems) const
+{
+    state->apply(_matrix, subsystems);
+    return state;
+}
+
 #ifndef Getters
 
-MatrixXcd UnitaryTransformation::transformMatrix()
+MatrixXcd UnitaryTransformation::transformMatrix() const
 {
     return _matrix;
 }
 
-HilbertSpace UnitaryTransformation::space()
+HilbertSpace UnitaryTransformation::space() const
 {
     return _space;
 }
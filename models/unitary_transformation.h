@@ -33,6 +33,9 @@
 
 using namespace Eigen;
 
+class ShardedStateVector;
+class VectorizedDensityMatrix;
+
 /**
  * General class for unirary transformations
  */
@@ -57,12 +60,12 @@ public:
     /**
      * Returns unirary matrix of the transform
      */
-    MatrixXcd transformMatrix();
+    MatrixXcd transformMatrix() const;
     
     /**
      * Returns space in which transform can be applied
      */
-    HilbertSpace space();
+    HilbertSpace space() const;
     
     /**
      * Apply current transform to the specified state. State will be changed according to transform matrix
@@ -70,6 +73,16 @@ public:
      */
     QuantumState* applyTo(QuantumState* state);
     
+    /**
+     * Apply current transform to listed subsystems of state vector sharded between processes, see ShardedStateVector
+     */
+    ShardedStateVector* applyTo(ShardedStateVector* state, const std::vector< int >& subsystems) const;
+    
+    /**
+     * Apply current transform to listed subsystems of vectorized density matrix, see VectorizedDensityMatrix
+     */
+    VectorizedDensityMatrix* applyTo(VectorizedDensityMatrix* state, const std::vector< int >& subsystems) const;
+    
 protected:
     /**
      * Empty constructor. Assume to be called only in derived class and derived class MUST set _matrix and _space variables
@@ -0,0 +1,205 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "vectorized_density_matrix.h"
+#include "kronecker_tensor.h"
+#include <stdexcept>
+
+#ifndef Constructors
+
+VectorizedDensityMatrix::VectorizedDensityMatrix(const HilbertSpace& space)
+{
+    _init(space);
+    _vector.setZero();
+    _vector(0, 0) = 1;
+}
+
+VectorizedDensityMatrix::VectorizedDensityMatrix(const MatrixXcd& density, const HilbertSpace& space)
+{
+    if (density.rows() != space.totalDimension() || density.cols() != density.rows())
+	throw std::invalid_argument("Space total dimension shold be the same as matrix is");
+    _init(space);
+    // index of p_ij is i * N + j, that is row-major order
+    int dim = density.rows();
+    Map< Matrix< std::complex< double >, Dynamic, Dynamic, RowMajor > >(_vector.data(), dim, dim) = density;
+}
+
+VectorizedDensityMatrix::VectorizedDensityMatrix(const QuantumState& state)
+{
+    *this = VectorizedDensityMatrix(state.densityMatrix(), state.space());
+}
+
+void VectorizedDensityMatrix::_init(const HilbertSpace& space)
+{
+    _space = space;
+    _superDimensions = space.dimensions();
+    _superDimensions.insert(_superDimensions.end(), _superDimensions.begin(), _superDimensions.end());
+    long long dim = space.totalDimension();
+    _vector.resize(dim * dim, 1);
+}
+
+#endif
+
+#ifndef Performing
+
+void VectorizedDensityMatrix::apply(const MatrixXcd& op, const std::vector< int >& subsystems)
+{
+    // (U (x) U*) |p>> is applied as two local gates, each in O(N^2 * d)
+    std::vector< int > columns = subsystems;
+    for (int i = 0; i < columns.size(); ++i) {
+	if (subsystems[i] < 0 || subsystems[i] >= _space.rank())
+	    throw std::invalid_argument("Index of subsystem is outside of space bounds");
+	columns[i] += _space.rank();
+    }
+    KroneckerTensor::applyToSubsystems(op, subsystems, _superDimensions, _vector);
+    KroneckerTensor::applyToSubsystems(op.conjugate(), columns, _superDimensions, _vector);
+}
+
+void VectorizedDensityMatrix::apply(const Circuit& circuit)
+{
+    if (circuit.space().totalDimension() != _space.totalDimension())
+	throw std::invalid_argument("Circuit space does not match state space");
+    for (int i = 0; i < circuit.gatesCount(); ++i)
+	apply(circuit.gate(i).matrix, circuit.gate(i).subsystems);
+}
+
+void VectorizedDensityMatrix::applyChannel(const std::vector< MatrixXcd >& kraus, const std::vector< int >& subsystems)
+{
+    applySuperoperator(superoperator(kraus), subsystems);
+}
+
+void VectorizedDensityMatrix::applySuperoperator(const MatrixXcd& superop, const std::vector< int >& subsystems)
+{
+    KroneckerTensor::applyToSubsystems(superop, _doubled(subsystems), _superDimensions, _vector);
+}
+
+int VectorizedDensityMatrix::measure(int subsystem, RandomGenerator& generator)
+{
+    if (subsystem < 0 || subsystem >= _space.rank())
+	throw std::invalid_argument("Index of subsystem is outside of space bounds");
+    int dim = _space.dimension(subsystem);
+    int low = 1;
+    for (int i = subsystem + 1; i < _space.rank(); ++i)
+	low *= _space.dimension(i);
+    
+    VectorXd probs = probabilities();
+    std::vector< double > weights(dim, 0);
+    for (int i = 0; i < probs.size(); ++i)
+	weights[(i / low) % dim] += probs[i];
+    double r = generator.uniform() * probs.sum();
+    int outcome = 0;
+    while (outcome < dim - 1 && r >= weights[outcome])
+	r -= weights[outcome++];
+    
+    // keep p_ij with both digits equal to outcome
+    long long size = _space.totalDimension();
+    for (long long row = 0; row < size; ++row)
+	for (long long col = 0; col < size; ++col)
+	    if ((row / low) % dim != outcome || (col / low) % dim != outcome)
+		_vector(row * size + col, 0) = 0;
+    _vector /= weights[outcome];
+    return outcome;
+}
+
+#endif
+
+#ifndef Getters
+
+VectorXd VectorizedDensityMatrix::probabilities() const
+{
+    long long size = _space.totalDimension();
+    VectorXd res(size);
+    for (long long i = 0; i < size; ++i)
+	res[i] = _vector(i * size + i, 0).real();
+    return res;
+}
+
+std::complex< double > VectorizedDensityMatrix::expectation(const MatrixXcd& op, const std::vector< int >& subsystems) const
+{
+    // O acting on row digits gives O * p, its trace is the sum of diagonal
+    MatrixXcd applied = _vector;
+    KroneckerTensor::applyToSubsystems(op, subsystems, _superDimensions, applied);
+    long long size = _space.totalDimension();
+    std::complex< double > res = 0;
+    for (long long i = 0; i < size; ++i)
+	res += applied(i * size + i, 0);
+    return res;
+}
+
+double VectorizedDensityMatrix::purity() const
+{
+    return _vector.squaredNorm();
+}
+
+MatrixXcd VectorizedDensityMatrix::densityMatrix() const
+{
+    int dim = _space.totalDimension();
+    return Map< const Matrix< std::complex< double >, Dynamic, Dynamic, RowMajor > >(_vector.data(), dim, dim);
+}
+
+QuantumState VectorizedDensityMatrix::toQuantumState() const
+{
+    return QuantumState(densityMatrix(), _space);
+}
+
+const MatrixXcd& VectorizedDensityMatrix::vector() const
+{
+    return _vector;
+}
+
+HilbertSpace VectorizedDensityMatrix::space() const
+{
+    return _space;
+}
+
+HilbertSpace VectorizedDensityMatrix::superSpace() const
+{
+    return HilbertSpace(_superDimensions);
+}
+
+MatrixXcd VectorizedDensityMatrix::superoperator(const std::vector< MatrixXcd >& kraus)
+{
+    if (kraus.empty())
+	throw std::invalid_argument("Channel should have at least one Kraus operator");
+    int dim = kraus[0].rows();
+    MatrixXcd res = MatrixXcd::Zero(dim * dim, dim * dim);
+    for (int i = 0; i < kraus.size(); ++i)
+	res += KroneckerTensor::product(kraus[i], kraus[i].conjugate());
+    return res;
+}
+
+std::vector< int > VectorizedDensityMatrix::_doubled(const std::vector< int >& subsystems) const
+{
+    std::vector< int > res = subsystems;
+    for (int i = 0; i < subsystems.size(); ++i) {
+	if (subsystems[i] < 0 || subsystems[i] >= _space.rank())
+	    throw std::invalid_argument("Index of subsystem is outside of space bounds");
+	res.push_back(subsystems[i] + _space.rank());
+    }
+    return res;
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VECTORIZED_DENSITY_MATRIX_H
+#define VECTORIZED_DENSITY_MATRIX_H
+
+#include "../Eigen/Core"
+#include "hilbert_space.h"
+#include "quantum_state.h"
+#include "circuit.h"
+#include "random_generator.h"
+#include <vector>
+
+using namespace Eigen;
+
+/**
+ * Density matrix of n subsystems stored as state vector |p>> = sum p_ij |i>|j> of 2n subsystems: subsystem k of
+ * the state is row digit k, subsystem n + k is column digit k. Gate U on subsystem k is U on k and U* on n + k,
+ * done by the same strided kernel as for state vectors, so a local gate costs O(N^2 * d) instead of dense products.
+ * Channels are superoperators sum K (x) K* on the two copies of subsystems
+ */
+class VectorizedDensityMatrix
+{
+public:
+    /**
+     * State |0...0><0...0| of space
+     */
+    VectorizedDensityMatrix(const HilbertSpace& space);
+    VectorizedDensityMatrix(const MatrixXcd& density, const HilbertSpace& space);
+    VectorizedDensityMatrix(const QuantumState& state);
+    
+    /**
+     * p = U * p * U^+ for operator on listed subsystems
+     */
+    void apply(const MatrixXcd& op, const std::vector< int >& subsystems);
+    void apply(const Circuit& circuit);
+    
+    /**
+     * Apply channel p = sum K_i * p * K_i^+ on listed subsystems
+     */
+    void applyChannel(const std::vector< MatrixXcd >& kraus, const std::vector< int >& subsystems);
+    
+    /**
+     * Apply superoperator given in order (row digits of subsystems, column digits of subsystems), see superoperator()
+     */
+    void applySuperoperator(const MatrixXcd& superop, const std::vector< int >& subsystems);
+    
+    /**
+     * Measure subsystem in computational basis and collapse the state
+     * @return Index of outcome
+     */
+    int measure(int subsystem, RandomGenerator& generator);
+    
+    VectorXd probabilities() const;
+    
+    /**
+     * Tr(p * O) for local operator
+     */
+    std::complex< double > expectation(const MatrixXcd& op, const std::vector< int >& subsystems) const;
+    
+    /**
+     * Tr(p^2) = <<p|p>>
+     */
+    double purity() const;
+    
+    /**
+     * Reshape vector to matrix (copies)
+     */
+    MatrixXcd densityMatrix() const;
+    QuantumState toQuantumState() const;
+    
+    /**
+     * Vector |p>> as a single column
+     */
+    const MatrixXcd& vector() const;
+    HilbertSpace space() const;
+    
+    /**
+     * Space of the vector, dimensions of space twice
+     */
+    HilbertSpace superSpace() const;
+    
+    /**
+     * Superoperator sum K_i (x) K_i* of channel
+     */
+    static MatrixXcd superoperator(const std::vector< MatrixXcd >& kraus);
+    
+private:
+    MatrixXcd _vector;
+    HilbertSpace _space;
+    std::vector< uint > _superDimensions;
+    
+    void _init(const HilbertSpace& space);
+    std::vector< int > _doubled(const std::vector< int >& subsystems) const;
+};
+
+#endif // VECTORIZED_DENSITY_MATRIX_H
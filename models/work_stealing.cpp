@@ -0,0 +1,86 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "work_stealing.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+void runWorkStealing(int tasks, int threads, const std::function< void (int, int) >& body)
+{
+    if (threads <= 0)
+	threads = std::max(1u, std::thread::hardware_concurrency());
+    int workersCount = std::max(1, std::min(threads, tasks));
+    std::vector< std::deque< int > > queues(workersCount);
+    std::vector< std::mutex > locks(workersCount);
+    for (int t = 0; t < tasks; ++t)
+	queues[t % workersCount].push_back(t);
+    
+    // the first exception stops dealing of tasks and is rethrown by the caller after all workers are joined
+    std::atomic< bool > failed(false);
+    std::exception_ptr error;
+    std::mutex errorLock;
+    auto work = [&](int worker) {
+	while (!failed.load()) {
+	    int task = -1;
+	    for (int k = 0; k < workersCount && task < 0; ++k) {
+		int victim = (worker + k) % workersCount;
+		std::lock_guard< std::mutex > guard(locks[victim]);
+		if (queues[victim].empty()) continue;
+		if (k == 0) {
+		    task = queues[victim].back();
+		    queues[victim].pop_back();
+		}
+		else {
+		    task = queues[victim].front();
+		    queues[victim].pop_front();
+		}
+	    }
+	    if (task < 0) return;
+	    try {
+		body(worker, task);
+	    }
+	    catch (...) {
+		std::lock_guard< std::mutex > guard(errorLock);
+		if (!error)
+		    error = std::current_exception();
+		failed.store(true);
+	    }
+	}
+    };
+    std::vector< std::thread > workers;
+    for (int w = 1; w < workersCount; ++w)
+	workers.push_back(std::thread(work, w));
+    work(0);
+    for (int w = 0; w < workers.size(); ++w)
+	workers[w].join();
+    if (error)
+	std::rethrow_exception(error);
+}
@@ -0,0 +1,41 @@
+/*
+    Copyright (c) 2013 Роман Большаков <rombolshak@russia.ru>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <functional>
+
+/**
+ * Run tasks 0..tasks-1 on pool of threads. Tasks are dealt to workers round-robin; every worker takes its own tasks from
+ * the back of its deque and, when it is empty, steals from the front of the others. Body is called as body(worker, task),
+ * so that worker can use its own scratch data; the calling thread is worker 0. If body throws, the rest of tasks is not
+ * started, and the first exception is rethrown after all workers finish
+ * @param threads Count of workers, 0 means hardware concurrency
+ */
+void runWorkStealing(int tasks, int threads, const std::function< void (int, int) >& body);
+
+#endif // WORK_STEALING_H